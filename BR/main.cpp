@@ -22,6 +22,7 @@ namespace {
    bool is_verbose(false);
    bool force_report_regeneration(false);
    bool update_all(false);
+   bool audit_query_plans(false);
 
    int ParseCommandLine(int argc, char** argv) {
       // http://www.radmangames.com/programming/how-to-use-boost-program_options
@@ -31,7 +32,8 @@ namespace {
          ("help,h",                                          "Help message")
          ("verbose,v", po::value<bool>(&is_verbose),         "Verbose output")            // "--v true" turns verbose reporting on
          ("bill,b",    po::value<std::string>(&str_bill_id), "generate bill report")      // "--bill AB12" generates report for AB 12, regardless of whether it needs to be updated
-         ("update,u",  po::value<bool>(&update_all),         "update all reports");       // "--update true" re-generates all reports
+         ("update,u",  po::value<bool>(&update_all),         "update all reports")        // "--update true" re-generates all reports
+         ("explain,e", po::value<bool>(&audit_query_plans),  "audit query plans");        // "--explain true" logs the queries that scan a table
       po::variables_map vm;
       try { 
          po::store(po::parse_command_line(argc, argv, desc), vm);       // throws on error
@@ -75,6 +77,7 @@ int main(int argc, char** argv) {
    ScopedElapsedTime elapsed_time("Starting BR","BR Run Time: ");
    ParseCommandLine(argc,argv);        // Extract command line arguments
    CAPublic db(false);                 // Do not import leg data.  That has already been done.
+   if (audit_query_plans) db.AuditQueryPlans();
 
    // Update all reports, regardless of whether they need it
    if (update_all) { Update::UpdateAllReports(db,fs::path(html_files_folder)); }
@@ -87,4 +90,6 @@ int main(int argc, char** argv) {
    
    // Update the entire Html folder (str_bill_id is empty)
    else Update::UpdateHtmlFolder(db,html_files_folder);
+
+   db.ReportQueryPlans();
 }
@@ -0,0 +1,351 @@
+//
+/// \page benchmark Benchmark
+/// \remark Benchmark times each stage of bill ranking over a pinned corpus: the lob files named in
+///         Results/ExpectedBillResults.txt, ranked with both RegexScore files.  Every lob file is read into memory
+///         before timing starts, so the stages are timed without file I/O.  For each stage it reports throughput
+///         in MB/s and bills/s, and the 50th and 99th percentile time spent on one bill.  The word-term scores of each
+///         bill, positive and negative, are checked against those of the legacy ranker's walk, run here with a regex
+///         per term over the same sorted words, so a faster matcher can't change a score unnoticed.
+///         "--scale 10" ranks the corpus ten times over, as ten times as many bills, to see how the stages and the
+///         database write hold up as the corpus grows.
+///         Heap allocations made while ranking are counted, through a replaced operator new.  Ranking reuses one
+///         scratch context, so once its buffers have grown in the first pass over the corpus, later passes should
+///         allocate nothing per bill.
+
+#include "BillRow.h"
+#include "BillScoreWriter.h"
+#include "BillText.h"
+#include "Configuration.h"
+#include "ConfigurationFilePath.h"
+#include "DB_capublic.h"
+#include "Logger.h"
+#include "RankingTermFile.h"
+#include "ScopedElapsedTime.h"
+#include "TermSet.h"
+#include "Tokenizer.h"
+#include "TextRanker.h"
+#include "Utility.h"
+
+#include <boost/atomic.hpp>
+#include <boost/filesystem/operations.hpp>
+#include "boost/program_options.hpp"
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   boost::atomic<unsigned long long> allocations(0);     // Calls of operator new, counted while counting is on
+   boost::atomic<bool>               counting(false);
+}
+
+// Every heap allocation in the process goes through these, so ranking's allocations can be counted
+void* operator new(size_t size) {
+   if (counting.load(boost::memory_order_relaxed)) allocations.fetch_add(1,boost::memory_order_relaxed);
+   void* result(malloc(size == 0 ? 1 : size));
+   if (!result) throw std::bad_alloc();
+   return result;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete  (void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+
+namespace {
+   std::string lob_folder;                                // Empty means the folder Circus ranks bills from
+   std::string expected_results("../Results/ExpectedBillResults.txt");
+   std::string scratch_database("../Results/Benchmark.db");
+   std::string negative_terms;                            // Empty means the RegexScore files named by the configuration
+   std::string positive_terms;
+   unsigned int scale(1);                                 // Times the corpus is ranked, each time as new bills
+   unsigned int score_batch_size(1000);                   // Bill scores written per database commit
+
+   const size_t SUCCESS(0);
+   const size_t ERROR_IN_COMMAND_LINE(1);
+   const size_t SCORE_MISMATCH(2);
+
+   enum Stage { Strip, Tokenize, Sort, WordRanking, PhraseRanking, DatabaseWrite, Stages };
+   const char* stage_names[Stages] = { "HTML strip", "Tokenize", "Sort", "Word ranking", "Phrase ranking", "DB write" };
+
+   typedef std::chrono::steady_clock Clock;
+
+   // A bill of the pinned corpus
+   struct PinnedBill {
+      std::string lob;
+      std::string contents;                               // The lob file, HTML and all
+   };
+
+   // A word term as the legacy ranker held it
+   struct LegacyTerm {
+      std::string lower_key;
+      std::regex  rx;
+      int         score;
+      LegacyTerm(const std::string& key,const std::string& pattern,int s) : lower_key(key), rx(pattern,std::regex::icase), score(s) {
+         std::transform(lower_key.begin(),lower_key.end(),lower_key.begin(),::tolower);
+      }
+   };
+
+   // Time spent on each bill by one stage, and the bytes of text it processed
+   struct StageTimes {
+      std::vector<double> seconds;
+      unsigned long long  bytes;
+      StageTimes() : bytes(0) {}
+      void Add(Clock::time_point start,size_t length) {
+         seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+         bytes += length;
+      }
+   };
+
+   int ParseCommandLine(int argc,char** argv) {
+      namespace po = boost::program_options;
+      po::options_description desc("Options");
+      desc.add_options()
+         ("help,h","Help message")
+         ("lobs,l",po::value<std::string>(&lob_folder),"Folder holding the lob files")                       // "--lobs D:/Bills" reads the corpus from D:/Bills
+         ("expected,e",po::value<std::string>(&expected_results),"Expected bill results")                   // "--expected Results.txt" pins the corpus to the bills listed there
+         ("database,d",po::value<std::string>(&scratch_database),"Scratch database for bill scores")        // "--database D:/Benchmark.db" writes scores there.  It is recreated each run.
+         ("negative,n",po::value<std::string>(&negative_terms),"Negative RegexScore file")
+         ("positive,p",po::value<std::string>(&positive_terms),"Positive RegexScore file")
+         ("scale,s",po::value<unsigned int>(&scale),"Times the corpus is ranked")                           // "--scale 10" ranks ten times as many bills
+         ("commit,c",po::value<unsigned int>(&score_batch_size),"Bill scores per commit");                  // "--commit 100"  commits bill scores 100 at a time
+      po::variables_map vm;
+      try {
+         po::store(po::parse_command_line(argc,argv,desc),vm);
+         if (vm.count("help")) {
+            std::cout << desc << std::endl;
+         }
+         po::notify(vm);
+      } catch (boost::program_options::error& e) {
+         std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+         return ERROR_IN_COMMAND_LINE;
+      }
+      if (scale == 0) scale = 1;
+      return SUCCESS;
+   }
+
+   void Report(const std::string& line) {
+      std::cout << line << std::endl;
+      LoggerNS::Logger::Log(line);
+   }
+
+   // Read the bills named in the expected results, each line of which is a score and a quoted lob file name.  The scores aren't used.
+   std::vector<PinnedBill> ReadCorpus() {
+      ScopedElapsedTime elapsed_time("Reading the pinned corpus","Corpus read: ");
+      std::vector<PinnedBill> result;
+      const std::regex rx_result("^\\s*(\\d+)\\s+\"([^\"]+)\"");
+      const std::vector<std::string> lines(ReadFileLineByLine(expected_results));
+      std::for_each(lines.begin(),lines.end(),[&](const std::string& line) {
+         std::smatch match;
+         if (!std::regex_search(line,match,rx_result)) return;
+         PinnedBill bill;
+         bill.lob = match[2];
+         const std::string path(lob_folder.empty() ? BillText::LobPath(bill.lob) : (fs::path(lob_folder) / bill.lob).string());
+         if (!fs::exists(path)) {
+            Report(std::string("Missing lob file ") + path);
+            return;
+         }
+         bill.contents = ReadFile(path);
+         result.push_back(bill);
+      });
+      return result;
+   }
+
+   // The positive and negative terms, compiled as Circus compiles them
+   TermSet CompileRankingTerms(const RankingTermFile& negative,const RankingTermFile& positive) {
+      TermSet result;
+      result.Add(negative.pairs,TermSet::Negative);
+      result.Add(positive.pairs,TermSet::Positive);
+      result.AddPhrases(negative.phrases,TermSet::Negative);
+      result.AddPhrases(positive.phrases,TermSet::Positive);
+      result.Compile();
+      return result;
+   }
+
+   // A file's word terms as the legacy ranker compiled them: one per key, the last defined, in the order of the lower case keys
+   std::vector<LegacyTerm> LegacyWordTerms(const RankingTermFile& file) {
+      std::map<std::string,const TermDefinition*> latest;
+      std::for_each(file.pairs.begin(),file.pairs.end(),[&](const TermDefinition& definition) { latest[definition.key] = &definition; });
+      std::vector<LegacyTerm> result;
+      std::for_each(latest.begin(),latest.end(),[&](const std::pair<const std::string,const TermDefinition*>& entry) {
+         result.push_back(LegacyTerm(entry.first,entry.second->regex,entry.second->score));
+      });
+      std::stable_sort(result.begin(),result.end(),[](const LegacyTerm& a,const LegacyTerm& b) { return a.lower_key < b.lower_key; });
+      return result;
+   }
+
+   // The legacy ranker's word score: each term counts the run of sorted words matching it that begins with its first
+   // match past the run the term before it counted
+   score_t LegacyWordScore(const TokenVector& sorted_words,const std::vector<LegacyTerm>& terms) {
+      score_t score(0);
+      auto start(sorted_words.cbegin());
+      for (auto term = terms.begin(); term != terms.end() && start != sorted_words.cend(); ++term) {
+         const auto matches([&](const Token& word) { return std::regex_search(word.begin(),word.end(),term->rx); });
+         const auto first(std::find_if(start,sorted_words.cend(),matches));
+         if (first == sorted_words.cend()) continue;
+         start = std::find_if_not(first,sorted_words.cend(),matches);
+         score += static_cast<score_t>(std::distance(first,start)) * term->score;
+      }
+      return score;
+   }
+
+   // A fresh database holding a BillRows row for each bill to be ranked, so every score write updates a row
+   boost::shared_ptr<DB_capublic> CreateScratchDatabase(size_t bills) {
+      boost::system::error_code ec;
+      fs::remove(scratch_database,ec);
+      boost::shared_ptr<DB_capublic> db(new DB_capublic(scratch_database));
+      db->ExecuteSQL("Create Table BillRows (Change Text, MeasureType Text, MeasureNum Text, NegativeScore Integer, PositiveScore Integer, "
+                     "Position Text, Lob Text, BillId Text, Bill Text, BillVersionId Text, Author Text, Title Text);");
+      db->ExecuteSQL("Begin Transaction;");
+      for (size_t i = 0; i < bills; ++i) {
+         std::stringstream ss;
+         ss << "Insert Into BillRows (MeasureType, MeasureNum) Values ('BM', '" << i << "');";
+         db->ExecuteSQL(ss.str());
+      }
+      db->ExecuteSQL("Commit Transaction;");
+      return db;
+   }
+
+   // Nearest-rank percentile of sorted times
+   double Percentile(const std::vector<double>& sorted,double percent) {
+      if (sorted.empty()) return 0;
+      const size_t rank(static_cast<size_t>(std::ceil(percent / 100 * sorted.size())));
+      return sorted[std::min(sorted.size(),std::max<size_t>(rank,1)) - 1];
+   }
+
+   void ReportStages(const StageTimes (&stages)[Stages]) {
+      std::stringstream header;
+      header << std::left << std::setw(16) << "Stage" << std::right
+             << std::setw(12) << "Seconds" << std::setw(12) << "MB/s" << std::setw(12) << "Bills/s"
+             << std::setw(12) << "p50 us" << std::setw(12) << "p99 us";
+      Report(header.str());
+      for (int s = 0; s < Stages; ++s) {
+         std::vector<double> sorted(stages[s].seconds);
+         std::sort(sorted.begin(),sorted.end());
+         double total(0);
+         std::for_each(sorted.begin(),sorted.end(),[&](double seconds) { total += seconds; });
+         std::stringstream ss;
+         ss << std::left << std::setw(16) << stage_names[s] << std::right << std::fixed << std::setprecision(3) << std::setw(12) << total;
+         if (total > 0 && stages[s].bytes > 0) ss << std::setprecision(1) << std::setw(12) << stages[s].bytes / total / (1024 * 1024);
+         else                                  ss << std::setw(12) << "-";
+         ss << std::setprecision(1) << std::setw(12) << (total > 0 ? sorted.size() / total : 0)
+            << std::setw(12) << Percentile(sorted,50) * 1e6 << std::setw(12) << Percentile(sorted,99) * 1e6;
+         Report(ss.str());
+      }
+   }
+}
+
+int main(int argc,char** argv) {
+   ScopedElapsedTime elapsed_time("Starting Benchmark","Benchmark Run Time: ");
+   if (ParseCommandLine(argc,argv) != SUCCESS) return ERROR_IN_COMMAND_LINE;
+   if (negative_terms.empty() || positive_terms.empty()) {
+      boost::scoped_ptr<Configuration> config(new Configuration(path_config_file));
+      if (negative_terms.empty()) negative_terms = config->Negative();
+      if (positive_terms.empty()) positive_terms = config->Positive();
+   }
+   const RankingTermFile negative(RankingTermFiles::Load(negative_terms));
+   const RankingTermFile positive(RankingTermFiles::Load(positive_terms));
+   const TermSet terms(CompileRankingTerms(negative,positive));
+   const std::vector<LegacyTerm> legacy_negative(LegacyWordTerms(negative));
+   const std::vector<LegacyTerm> legacy_positive(LegacyWordTerms(positive));
+   const std::vector<PinnedBill> corpus(ReadCorpus());
+   if (corpus.empty()) {
+      Report(std::string("No lob files named in ") + expected_results + " could be read");
+      return ERROR_IN_COMMAND_LINE;
+   }
+   boost::shared_ptr<DB_capublic> db(CreateScratchDatabase(corpus.size() * scale));
+   BillScoreWriter writer(db,score_batch_size);
+
+   std::stringstream ss;
+   ss << "Ranking " << corpus.size() << " bills " << scale << " times with " << terms.Size() << " ranking terms";
+   Report(ss.str());
+   StageTimes stages[Stages];
+   for (int s = 0; s < Stages; ++s) stages[s].seconds.reserve(corpus.size() * scale);
+   std::vector<std::string> mismatches;
+   RankingScratch scratch;                                // Ranking's buffers, reused for every bill
+   const std::string& text(scratch.text);
+   TokenVector& words(scratch.words);
+   std::vector<unsigned int>& counts(scratch.counts);
+   std::vector<unsigned int> word_counts;                 // counts with the phrases left out, to check against the legacy walk
+   unsigned long long first_pass_allocations(0);
+   for (unsigned int copy = 0; copy < scale; ++copy) {
+      for (size_t i = 0; i < corpus.size(); ++i) {
+         const PinnedBill& bill(corpus[i]);
+         counting = true;
+         Clock::time_point start(Clock::now());
+         BillText::StripBillText(bill.contents,scratch.text,scratch.tags);
+         stages[Strip].Add(start,bill.contents.length());
+
+         start = Clock::now();
+         Tokenizer::Tokenize(text,words);
+         stages[Tokenize].Add(start,text.length());
+
+         // Phrases are counted over the words in text order, so before they are sorted
+         counts.assign(terms.Size(),0);
+         start = Clock::now();
+         terms.CountPhrases(text,words,counts,scratch.terms);
+         stages[PhraseRanking].Add(start,text.length());
+
+         start = Clock::now();
+         std::sort(words.begin(),words.end());
+         stages[Sort].Add(start,text.length());
+
+         start = Clock::now();
+         terms.CountWords(words,counts,scratch.terms);
+         const TermSetScores scores(terms.Tally(counts,false));
+         stages[WordRanking].Add(start,text.length());
+         counting = false;
+
+         BillRow row;
+         row.measure_type = "BM";
+         row.measure_num = DB_capublic::FrUInt(static_cast<unsigned int>(copy * corpus.size() + i));
+         row.bill = row.bill_version_id = row.lob = bill.lob;
+         row.neg_score = scores.neg_score;
+         row.pos_score = scores.pos_score;
+         start = Clock::now();
+         writer.Write(row);
+         stages[DatabaseWrite].Add(start,0);
+
+         if (copy == 0) {
+            word_counts.assign(counts.begin(),counts.end());
+            for (unsigned int t = 0; t < word_counts.size(); ++t) if (terms.IsPhrase(t)) word_counts[t] = 0;
+            const TermSetScores word_scores(terms.Tally(word_counts,false));
+            const score_t neg_expected(LegacyWordScore(words,legacy_negative));
+            const score_t pos_expected(LegacyWordScore(words,legacy_positive));
+            if (word_scores.neg_score != neg_expected || word_scores.pos_score != pos_expected) {
+               std::stringstream mismatch;
+               mismatch << bill.lob << ": the legacy walk scored negative " << neg_expected << ", positive " << pos_expected
+                        << "; word terms ranked negative " << word_scores.neg_score << ", positive " << word_scores.pos_score;
+               mismatches.push_back(mismatch.str());
+            }
+         }
+      }
+      if (copy == 0) first_pass_allocations = allocations;
+   }
+   // The last commit is charged to the last bill written
+   const Clock::time_point start(Clock::now());
+   writer.Flush();
+   stages[DatabaseWrite].seconds.back() += std::chrono::duration<double>(Clock::now() - start).count();
+
+   ReportStages(stages);
+   std::stringstream heap;
+   heap << "Heap allocations while ranking: " << first_pass_allocations << " in the first pass, as buffers grew";
+   if (scale > 1) {
+      heap << ", " << std::setprecision(2) << std::fixed
+           << static_cast<double>(allocations - first_pass_allocations) / (corpus.size() * (scale - 1)) << " per bill after it";
+   }
+   Report(heap.str());
+   std::for_each(mismatches.begin(),mismatches.end(),[&](const std::string& mismatch) { Report(mismatch); });
+   std::stringstream summary;
+   summary << corpus.size() - mismatches.size() << " of " << corpus.size() << " bills scored as the legacy walk scores them";
+   Report(summary.str());
+   return mismatches.empty() ? SUCCESS : SCORE_MISMATCH;
+}
@@ -0,0 +1,68 @@
+#include <BillProfileScores.h>
+#include "db_capublic.h"
+#include <Logger.h>
+
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   const std::string sql_create_bill_profile_score_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_profile_score_tbl ("
+      "bill_version_id TEXT    NOT NULL, "
+      "profile         TEXT    NOT NULL, "
+      "neg_score       INTEGER NOT NULL, "
+      "pos_score       INTEGER NOT NULL, "
+      "PRIMARY KEY (bill_version_id, profile)"
+      ");"
+   );
+
+   sqlite3_stmt* Prepare(sqlite3* db,const char* sql) {
+      sqlite3_stmt* result(NULL);
+      if (sqlite3_prepare_v2(db,sql,-1,&result,NULL) != SQLITE_OK) {
+         LoggerNS::Logger::Log(std::string("BillProfileScores was unable to prepare ") + sql);
+         sqlite3_finalize(result);
+         result = NULL;
+      }
+      return result;
+   }
+}
+
+BillProfileScores::BillProfileScores(boost::weak_ptr<DB_capublic> database,bool import_leg_data) : db_public(database) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp && !wp->ExecuteSQL(sql_create_bill_profile_score_tbl)) LoggerNS::Logger::Log("Unable to create bill_profile_score_tbl");
+}
+
+// Store a version's scores under each profile.  A savepoint lets the writes join a batch the score writer has open.
+bool BillProfileScores::Write(const bill_ver_id_t& bill_version_id,const std::vector<ProfileScore>& scores) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Savepoint profile_scores;")) return false;
+   sqlite3_stmt* insert(Prepare(wp->db,
+      "Insert Or Replace Into bill_profile_score_tbl (bill_version_id, profile, neg_score, pos_score) Values (?, ?, ?, ?);"));
+   bool result(insert != NULL);
+   std::for_each(scores.begin(),scores.end(),[&](const ProfileScore& score) {
+      if (!insert) return;
+      sqlite3_bind_text(insert,1,bill_version_id.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_text(insert,2,score.profile.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_int (insert,3,static_cast<int>(score.neg_score));
+      sqlite3_bind_int (insert,4,static_cast<int>(score.pos_score));
+      if (sqlite3_step(insert) != SQLITE_DONE) result = false;
+      sqlite3_reset(insert);
+   });
+   sqlite3_finalize(insert);
+   wp->ExecuteSQL(result ? "Release profile_scores;" : "Rollback To profile_scores; Release profile_scores;");
+   return result;
+}
+
+// Drop the scores of profiles no longer in the configuration
+bool BillProfileScores::Retain(const std::vector<std::string>& profiles) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp) return false;
+   std::stringstream ss;
+   ss << "Delete From bill_profile_score_tbl Where profile Not In (";
+   for (size_t i = 0; i < profiles.size(); ++i) ss << (i > 0 ? ", " : "") << DB_capublic::Quote(profiles[i]);
+   ss << ");";
+   return wp->ExecuteSQL(ss.str());
+}
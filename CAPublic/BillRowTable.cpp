@@ -12,7 +12,13 @@
 #define QC DB_capublic::QuoteC
 #define IC DB_capublic::IComma
 
-BillRowTable::BillRowTable(boost::weak_ptr<DB_capublic> database, bool import_leg_data) : db_public(database) { }
+// BillRows is created outside Circus.  Its rows are found by measure, so that is indexed once the table exists.
+BillRowTable::BillRowTable(boost::weak_ptr<DB_capublic> database, bool import_leg_data) : db_public(database) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp && wp->Count("sqlite_master"," Where type = 'table' And name = 'BillRows'") > 0) {
+      wp->ExecuteSQL("CREATE INDEX IF NOT EXISTS BillRows_measure ON BillRows (MeasureType, MeasureNum);");
+   }
+}
 
 // Insert a single BillRow into the database
 bool BillRowTable::Insert(const BillRow& row) {
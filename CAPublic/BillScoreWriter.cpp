@@ -0,0 +1,57 @@
+#include <BillScoreWriter.h>
+#include "db_capublic.h"
+#include <Logger.h>
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+
+namespace {
+   const char* sql_update_scores("Update BillRows Set NegativeScore = ?, PositiveScore = ?, BillVersionId = ? Where MeasureType = ? And MeasureNum = ?;");
+}
+
+BillScoreWriter::BillScoreWriter(boost::weak_ptr<DB_capublic> database,size_t size) : db_public(database), update(NULL), pending(0) {
+   BatchSize(size);
+}
+
+// Open a transaction and prepare the update statement for the next batch
+bool BillScoreWriter::Begin() {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Begin Transaction;")) return false;
+   if (sqlite3_prepare_v2(wp->db,sql_update_scores,-1,&update,NULL) != SQLITE_OK) {
+      LoggerNS::Logger::Log(std::string("BillScoreWriter was unable to prepare ") + sql_update_scores);
+      sqlite3_finalize(update);
+      update = NULL;
+      wp->ExecuteSQL("Rollback Transaction;");
+      return false;
+   }
+   return true;
+}
+
+// Update a bill's scores.  The update is committed once batch_size updates are pending.
+bool BillScoreWriter::Write(const BillRow& row) {
+   if (!update && !Begin()) return false;
+   sqlite3_bind_int (update,1,static_cast<int>(row.neg_score));
+   sqlite3_bind_int (update,2,static_cast<int>(row.pos_score));
+   sqlite3_bind_text(update,3,row.bill.c_str(),-1,SQLITE_TRANSIENT);
+   sqlite3_bind_text(update,4,row.measure_type.c_str(),-1,SQLITE_TRANSIENT);
+   sqlite3_bind_text(update,5,row.measure_num.c_str(),-1,SQLITE_TRANSIENT);
+   const bool result(sqlite3_step(update) == SQLITE_DONE);
+   sqlite3_reset(update);
+   ++pending;
+   if (pending >= batch_size) Flush();
+   return result;
+}
+
+// Commit all pending updates
+bool BillScoreWriter::Flush() {
+   if (!update) return true;
+   sqlite3_finalize(update);                             // Release the statement so the connection can always close
+   update = NULL;
+   pending = 0;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Commit Transaction;")) {
+      LoggerNS::Logger::Log("BillScoreWriter was unable to commit bill scores");
+      return false;
+   }
+   return true;
+}
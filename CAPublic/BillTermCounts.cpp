@@ -0,0 +1,199 @@
+#include <BillTermCounts.h>
+#include "db_capublic.h"
+#include <Logger.h>
+#include <Readers.h>
+
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   const std::string sql_create_bill_term_count_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_term_count_tbl ("
+      "bill_version_id TEXT    NOT NULL, "
+      "polarity        INTEGER NOT NULL, "
+      "term_key        TEXT    NOT NULL, "
+      "count           INTEGER NOT NULL, "
+      "PRIMARY KEY (bill_version_id, polarity, term_key)"
+      ");"
+   );
+   const std::string sql_create_bill_term_version_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_term_version_tbl (bill_version_id TEXT NOT NULL PRIMARY KEY);"
+   );
+   const std::string sql_create_ranking_term_tbl(
+      "CREATE TABLE IF NOT EXISTS ranking_term_tbl ("
+      "term_key TEXT    NOT NULL, "
+      "polarity INTEGER NOT NULL, "
+      "hash     TEXT    NOT NULL, "
+      "PRIMARY KEY (polarity, term_key)"
+      ");"
+   );
+   const std::string sql_create_bill_amendment_delta_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_amendment_delta_tbl ("
+      "bill_version_id     TEXT    NOT NULL PRIMARY KEY, "
+      "previous_version_id TEXT    NOT NULL, "
+      "neg_delta           INTEGER NOT NULL, "
+      "pos_delta           INTEGER NOT NULL"
+      ");"
+   );
+
+   std::string ColumnText(sqlite3_stmt* statement,int column) {
+      const char* text(reinterpret_cast<const char*>(sqlite3_column_text(statement,column)));
+      return text ? std::string(text) : std::string();
+   }
+
+   sqlite3_stmt* Prepare(sqlite3* db,const char* sql) {
+      sqlite3_stmt* result(NULL);
+      if (sqlite3_prepare_v2(db,sql,-1,&result,NULL) != SQLITE_OK) {
+         LoggerNS::Logger::Log(std::string("BillTermCounts was unable to prepare ") + sql);
+         sqlite3_finalize(result);
+         result = NULL;
+      }
+      return result;
+   }
+}
+
+BillTermCounts::BillTermCounts(boost::weak_ptr<DB_capublic> database,bool import_leg_data) : db_public(database), erase(NULL), insert(NULL), mark(NULL) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      if (!wp->ExecuteSQL(sql_create_bill_term_count_tbl + sql_create_bill_term_version_tbl + sql_create_ranking_term_tbl + sql_create_bill_amendment_delta_tbl)) {
+         LoggerNS::Logger::Log("Unable to create the bill term count tables");
+      }
+   }
+}
+
+// The ranking terms the counted versions were counted against
+std::vector<RankingTermRecord> BillTermCounts::RankingTerms() {
+   std::vector<RankingTermRecord> result;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      sqlite3_stmt* select(Prepare(wp->db,"Select term_key, polarity, hash From ranking_term_tbl;"));
+      while (select && sqlite3_step(select) == SQLITE_ROW) {
+         result.push_back(RankingTermRecord(ColumnText(select,0),sqlite3_column_int(select,1),ColumnText(select,2)));
+      }
+      sqlite3_finalize(select);
+   }
+   return result;
+}
+
+// Record the ranking terms the counted versions are now counted against, and drop counts of terms no longer used
+bool BillTermCounts::ReplaceRankingTerms(const std::vector<RankingTermRecord>& terms) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Savepoint ranking_terms; Delete From ranking_term_tbl;")) return false;
+   bool result(true);
+   sqlite3_stmt* insert(Prepare(wp->db,"Insert Or Replace Into ranking_term_tbl (term_key, polarity, hash) Values (?, ?, ?);"));
+   std::for_each(terms.begin(),terms.end(),[&](const RankingTermRecord& term) {
+      if (!insert) { result = false; return; }
+      sqlite3_bind_text(insert,1,term.term_key.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_int (insert,2,term.polarity);
+      sqlite3_bind_text(insert,3,term.hash.c_str(),-1,SQLITE_STATIC);
+      if (sqlite3_step(insert) != SQLITE_DONE) result = false;
+      sqlite3_reset(insert);
+   });
+   sqlite3_finalize(insert);
+   result = result && wp->ExecuteSQL(
+      "Delete From bill_term_count_tbl Where Not Exists (Select 1 From ranking_term_tbl "
+      "Where ranking_term_tbl.polarity = bill_term_count_tbl.polarity And ranking_term_tbl.term_key = bill_term_count_tbl.term_key);");
+   wp->ExecuteSQL(result ? "Release ranking_terms;" : "Rollback To ranking_terms; Release ranking_terms;");
+   return result;
+}
+
+std::vector<bill_ver_id_t> BillTermCounts::CountedVersions() {
+   return Readers::ReadVectorString(db_public,"Select bill_version_id From bill_term_version_tbl;");
+}
+
+// All stored counts of all counted versions
+std::map<bill_ver_id_t,std::vector<TermCount>> BillTermCounts::Read() {
+   std::map<bill_ver_id_t,std::vector<TermCount>> result;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      sqlite3_stmt* select(Prepare(wp->db,
+         "Select bill_version_id, polarity, term_key, count From bill_term_count_tbl "
+         "Where bill_version_id In (Select bill_version_id From bill_term_version_tbl);"));
+      while (select && sqlite3_step(select) == SQLITE_ROW) {
+         result[ColumnText(select,0)].push_back(
+            TermCount(ColumnText(select,2),sqlite3_column_int(select,1),static_cast<unsigned int>(sqlite3_column_int(select,3))));
+      }
+      sqlite3_finalize(select);
+   }
+   return result;
+}
+
+// Prepare the statements Write runs for every version it stores
+bool BillTermCounts::PrepareWrite(sqlite3* db) {
+   if (!erase)  erase  = Prepare(db,"Delete From bill_term_count_tbl Where bill_version_id = ? And polarity = ? And term_key = ?;");
+   if (!insert) insert = Prepare(db,"Insert Into bill_term_count_tbl (bill_version_id, polarity, term_key, count) Values (?, ?, ?, ?);");
+   if (!mark)   mark   = Prepare(db,"Insert Or Ignore Into bill_term_version_tbl (bill_version_id) Values (?);");
+   return erase && insert && mark;
+}
+
+void BillTermCounts::Finalize() {
+   sqlite3_finalize(erase);
+   sqlite3_finalize(insert);
+   sqlite3_finalize(mark);
+   erase = insert = mark = NULL;
+}
+
+// Store a version's counts for some terms, replacing earlier counts of those terms, and mark the version counted.
+// Zero counts remove the stored count.  Savepoints let the writes join a batch the score writer has open.
+bool BillTermCounts::Write(const bill_ver_id_t& bill_version_id,const std::vector<TermCount>& counts) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Savepoint term_counts;")) return false;
+   bool result(PrepareWrite(wp->db));
+   if (result) {
+      std::for_each(counts.begin(),counts.end(),[&](const TermCount& count) {
+         sqlite3_bind_text(erase,1,bill_version_id.c_str(),-1,SQLITE_STATIC);
+         sqlite3_bind_int (erase,2,count.polarity);
+         sqlite3_bind_text(erase,3,count.term_key.c_str(),-1,SQLITE_STATIC);
+         if (sqlite3_step(erase) != SQLITE_DONE) result = false;
+         sqlite3_reset(erase);
+         if (count.count > 0) {
+            sqlite3_bind_text(insert,1,bill_version_id.c_str(),-1,SQLITE_STATIC);
+            sqlite3_bind_int (insert,2,count.polarity);
+            sqlite3_bind_text(insert,3,count.term_key.c_str(),-1,SQLITE_STATIC);
+            sqlite3_bind_int (insert,4,static_cast<int>(count.count));
+            if (sqlite3_step(insert) != SQLITE_DONE) result = false;
+            sqlite3_reset(insert);
+         }
+      });
+      sqlite3_bind_text(mark,1,bill_version_id.c_str(),-1,SQLITE_STATIC);
+      if (sqlite3_step(mark) != SQLITE_DONE) result = false;
+      sqlite3_reset(mark);
+   }
+   wp->ExecuteSQL(result ? "Release term_counts;" : "Rollback To term_counts; Release term_counts;");
+   return result;
+}
+
+// Drop versions from the counted set, so their counts are rebuilt from their text the next time they are ranked
+bool BillTermCounts::Uncount(const std::vector<bill_ver_id_t>& bill_version_ids) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp) return false;
+   std::stringstream ss;
+   ss << "Savepoint uncount;";
+   std::for_each(bill_version_ids.begin(),bill_version_ids.end(),[&](const bill_ver_id_t& id) {
+      ss << "Delete From bill_term_count_tbl Where bill_version_id = " << DB_capublic::Quote(id) << ";"
+         << "Delete From bill_term_version_tbl Where bill_version_id = " << DB_capublic::Quote(id) << ";";
+   });
+   ss << "Release uncount;";
+   return wp->ExecuteSQL(ss.str());
+}
+
+// Record how much a version's amendments changed its scores from those of the version it amends
+bool BillTermCounts::WriteAmendmentDelta(const bill_ver_id_t& bill_version_id,const AmendmentDelta& delta) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp) return false;
+   bool result(false);
+   sqlite3_stmt* insert(Prepare(wp->db,
+      "Insert Or Replace Into bill_amendment_delta_tbl (bill_version_id, previous_version_id, neg_delta, pos_delta) Values (?, ?, ?, ?);"));
+   if (insert) {
+      sqlite3_bind_text(insert,1,bill_version_id.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_text(insert,2,delta.previous_version_id.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_int (insert,3,delta.neg_delta);
+      sqlite3_bind_int (insert,4,delta.pos_delta);
+      result = sqlite3_step(insert) == SQLITE_DONE;
+   }
+   sqlite3_finalize(insert);
+   return result;
+}
@@ -0,0 +1,185 @@
+#include <BillText.h>
+#include <BillWordIndex.h>
+#include "db_capublic.h"
+#include <Logger.h>
+#include <Readers.h>
+#include <ScopedElapsedTime.h>
+#include <Tokenizer.h>
+#include <Utility.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   const std::string sql_create_bill_word_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_word_tbl ("
+      "word            TEXT    NOT NULL, "
+      "bill_version_id TEXT    NOT NULL, "
+      "count           INTEGER NOT NULL"
+      ");"
+      "CREATE INDEX IF NOT EXISTS bill_word_tbl_word ON bill_word_tbl (word);"
+      "CREATE INDEX IF NOT EXISTS bill_word_tbl_version ON bill_word_tbl (bill_version_id);"
+   );
+   // The lob file each indexed bill version was read from.  A version whose lob file changes is indexed again.
+   const std::string sql_create_bill_word_lob_tbl(
+      "CREATE TABLE IF NOT EXISTS bill_word_lob_tbl ("
+      "bill_version_id TEXT NOT NULL PRIMARY KEY, "
+      "lob             TEXT NOT NULL"
+      ");"
+   );
+
+   // Indexes built before words kept their case hold only lower case words.  Every bill has capitalized words,
+   // so an index without any is one of those.
+   const std::string sql_lower_case_index(
+      "Select 1 Where Exists (Select 1 From bill_word_tbl) And Not Exists (Select 1 From bill_word_tbl Where word <> lower(word));"
+   );
+
+   // Count the occurrences of each word in a bill's text
+   std::map<std::string,unsigned int> CountWords(const std::string& contents) {
+      std::map<std::string,unsigned int> result;
+      TokenVector words;
+      Tokenizer::Tokenize(contents,words);
+      std::for_each(words.begin(),words.end(),[&](const Token& token) { ++result[std::string(token.begin(),token.end())]; });
+      return result;
+   }
+}
+
+// Constructor ensures that the index tables exist, and indexes new lob files when importing leg site data
+BillWordIndex::BillWordIndex(boost::weak_ptr<DB_capublic> database,bool import_leg_data) : db_public(database) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      if (wp->ExecuteSQL(sql_create_bill_word_tbl) && wp->ExecuteSQL(sql_create_bill_word_lob_tbl)) {
+         if (!Readers::ReadVectorString(db_public,sql_lower_case_index).empty()) {
+            LoggerNS::Logger::Log("The bill word index holds lower case words only; it is emptied, to be built again with words as cased in the text");
+            wp->ExecuteSQL("Delete From bill_word_tbl; Delete From bill_word_lob_tbl;");
+         }
+         if (import_leg_data) Update();
+      } else {
+         LoggerNS::Logger::Log("Unable to create the bill word index tables");
+      }
+   }
+}
+
+// Index every bill version whose lob file hasn't been indexed
+void BillWordIndex::Update() {
+   ScopedElapsedTime elapsed_time("\tUpdating bill word index","\tBill word index update time: ");
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      const std::string query(
+         "Select bill_version_id, bill_xml From bill_version_tbl Where bill_xml Is Not Null And Not Exists "
+         "(Select 1 From bill_word_lob_tbl Where bill_word_lob_tbl.bill_version_id = bill_version_tbl.bill_version_id "
+         "And bill_word_lob_tbl.lob = bill_version_tbl.bill_xml);");
+      const std::vector<std::vector<std::string>> versions(Readers::ReadVectorVector(db_public,query));
+      unsigned int indexed(0);
+      if (wp->ExecuteSQL("Begin Transaction;")) {
+         std::for_each(versions.begin(),versions.end(),[&](const std::vector<std::string>& version) {
+            if (version.size() == 2 && IndexVersion(version[0],version[1])) ++indexed;
+         });
+         wp->ExecuteSQL("Commit Transaction;");
+      }
+      std::stringstream ss;
+      ss << "\tIndexed the words of " << indexed << " of " << versions.size() << " new bill versions.";
+      LoggerNS::Logger::Log(ss.str());
+   }
+}
+
+// Replace a bill version's postings with the word counts from its lob file
+bool BillWordIndex::IndexVersion(const bill_ver_id_t& bill_version_id,const bill_lob_t& lob) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp) return false;
+   const std::string lob_path(BillText::LobPath(lob));
+   if (!boost::filesystem::exists(lob_path)) {
+      LoggerNS::Logger::Log(std::string("\tBill word index: no lob file ") + lob_path);
+      return false;
+   }
+   const std::string contents(BillText::ReadBillText(lob_path));
+   const std::map<std::string,unsigned int> counts(CountWords(contents));
+
+   // The version is recorded as indexed only once all its postings are in, so a failure leaves it to be indexed again
+   if (!wp->ExecuteSQL("Savepoint index_version;")) return false;
+   std::stringstream ss;
+   ss << "Delete From bill_word_tbl Where bill_version_id = " << DB_capublic::Quote(bill_version_id) << ";";
+   bool result(wp->ExecuteSQL(ss.str()));
+   sqlite3_stmt* insert(NULL);
+   const char* sql("Insert Into bill_word_tbl (word, bill_version_id, count) Values (?, ?, ?);");
+   if (result && sqlite3_prepare_v2(wp->db,sql,-1,&insert,NULL) != SQLITE_OK) {
+      LoggerNS::Logger::Log(std::string("BillWordIndex::IndexVersion was unable to prepare ") + sql);
+      result = false;
+   }
+   if (result) {
+      sqlite3_bind_text(insert,2,bill_version_id.c_str(),-1,SQLITE_TRANSIENT);
+      std::for_each(counts.begin(),counts.end(),[&](const std::pair<const std::string,unsigned int>& count) {
+         sqlite3_bind_text(insert,1,count.first.c_str(),static_cast<int>(count.first.length()),SQLITE_STATIC);
+         sqlite3_bind_int (insert,3,static_cast<int>(count.second));
+         if (sqlite3_step(insert) != SQLITE_DONE) result = false;
+         sqlite3_reset(insert);
+      });
+   }
+   sqlite3_finalize(insert);
+   if (result) {
+      std::stringstream lob_row;
+      lob_row << "Insert Or Replace Into bill_word_lob_tbl (bill_version_id, lob) Values ("
+              << DB_capublic::QuoteC(bill_version_id) << DB_capublic::Quote(lob) << ");";
+      result = wp->ExecuteSQL(lob_row.str());
+   }
+   wp->ExecuteSQL(result ? "Release index_version;" : "Rollback To index_version; Release index_version;");
+   if (!result) LoggerNS::Logger::Log(std::string("\tBill word index: unable to index ") + bill_version_id);
+   return result;
+}
+
+// All distinct words in the index
+std::vector<std::string> BillWordIndex::Words() {
+   return Readers::ReadVectorString(db_public,"Select Distinct word From bill_word_tbl;");
+}
+
+// The bill versions whose words are in the index
+std::vector<bill_ver_id_t> BillWordIndex::IndexedVersions() {
+   return Readers::ReadVectorString(db_public,"Select bill_version_id From bill_word_lob_tbl;");
+}
+
+// The bill versions containing a word, with the number of times each contains it
+std::vector<WordPosting> BillWordIndex::Postings(const std::string& word) {
+   std::vector<WordPosting> result;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      sqlite3_stmt* select(NULL);
+      const char* sql("Select bill_version_id, count From bill_word_tbl Where word = ?;");
+      if (sqlite3_prepare_v2(wp->db,sql,-1,&select,NULL) == SQLITE_OK) {
+         sqlite3_bind_text(select,1,word.c_str(),static_cast<int>(word.length()),SQLITE_STATIC);
+         while (sqlite3_step(select) == SQLITE_ROW) {
+            const char* id(reinterpret_cast<const char*>(sqlite3_column_text(select,0)));
+            result.push_back(WordPosting(id ? id : "",static_cast<unsigned int>(sqlite3_column_int(select,1))));
+         }
+      } else {
+         LoggerNS::Logger::Log(std::string("BillWordIndex::Postings was unable to prepare ") + sql);
+      }
+      sqlite3_finalize(select);
+   }
+   return result;
+}
+
+// The words of a bill version, with the number of times it contains each
+std::vector<WordCount> BillWordIndex::Words(const bill_ver_id_t& bill_version_id) {
+   std::vector<WordCount> result;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      sqlite3_stmt* select(NULL);
+      const char* sql("Select word, count From bill_word_tbl Where bill_version_id = ?;");
+      if (sqlite3_prepare_v2(wp->db,sql,-1,&select,NULL) == SQLITE_OK) {
+         sqlite3_bind_text(select,1,bill_version_id.c_str(),static_cast<int>(bill_version_id.length()),SQLITE_STATIC);
+         while (sqlite3_step(select) == SQLITE_ROW) {
+            const char* word(reinterpret_cast<const char*>(sqlite3_column_text(select,0)));
+            result.push_back(WordCount(word ? word : "",static_cast<unsigned int>(sqlite3_column_int(select,1))));
+         }
+      } else {
+         LoggerNS::Logger::Log(std::string("BillWordIndex::Words was unable to prepare ") + sql);
+      }
+      sqlite3_finalize(select);
+   }
+   return result;
+}
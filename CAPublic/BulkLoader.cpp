@@ -0,0 +1,148 @@
+#include "BulkLoader.h"
+#include "db_capublic.h"
+#include <Logger.h>
+
+#include <boost/shared_ptr.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   // Run a pragma, answering the first column of its first row.  sqlite3_exec would report the row as an error.
+   std::string Pragma(sqlite3* db,const std::string& sql) {
+      std::string result;
+      sqlite3_stmt* pragma(NULL);
+      if (sqlite3_prepare_v2(db,sql.c_str(),-1,&pragma,NULL) == SQLITE_OK && sqlite3_step(pragma) == SQLITE_ROW) {
+         const char* text(reinterpret_cast<const char*>(sqlite3_column_text(pragma,0)));
+         if (text) result = text;
+      }
+      sqlite3_finalize(pragma);
+      return result;
+   }
+
+   std::string ColumnList(const std::vector<std::string>& columns) {
+      std::stringstream names;
+      for (size_t i = 0; i < columns.size(); ++i) names << (i > 0 ? ", " : "") << columns[i];
+      return names.str();
+   }
+
+   std::string InsertSQL(const std::string& table,const std::string& column_list,size_t column_count) {
+      std::stringstream values;
+      for (size_t i = 0; i < column_count; ++i) values << (i > 0 ? ", " : "") << "?";
+      return std::string("Insert into ") + table + " (" + column_list + ") Values (" + values.str() + ");";
+   }
+
+   // lhs.c Is rhs.c for each column c.  Is, unlike =, matches NULL to NULL.
+   std::string Matching(const std::vector<std::string>& columns,const std::string& lhs,const std::string& rhs) {
+      std::stringstream match;
+      for (size_t i = 0; i < columns.size(); ++i) match << (i > 0 ? " And " : "") << lhs << "." << columns[i] << " Is " << rhs << "." << columns[i];
+      return match.str();
+   }
+}
+
+BulkLoader::BulkLoader(boost::weak_ptr<DB_capublic> database,const std::string& _table,const std::vector<std::string>& columns,bool unjournaled)
+   : db(database.lock()), table(_table), column_list(ColumnList(columns)), column_count(columns.size()), insert(NULL), rows(0), failures(0), deleted(0) {
+   if (!db) return;
+   if (unjournaled) {
+      journal_mode = Pragma(db->db,"PRAGMA journal_mode;");
+      if (Pragma(db->db,"PRAGMA journal_mode = OFF;") != "off") {
+         LoggerNS::Logger::Log(std::string("Unable to turn off the journal for loading ") + table);
+         journal_mode.clear();
+      }
+   }
+   if (!db->ExecuteSQL("Begin Transaction;")) {
+      Finish(NULL);
+      return;
+   }
+   const std::string sql(InsertSQL(table,column_list,column_count));
+   if (sqlite3_prepare_v2(db->db,sql.c_str(),-1,&insert,NULL) != SQLITE_OK) {
+      LoggerNS::Logger::Log(std::string("BulkLoader was unable to prepare ") + sql);
+      Finish("Rollback Transaction;");
+   }
+}
+
+BulkLoader::~BulkLoader() {
+   if (!insert) return;
+   std::stringstream ss;
+   ss << "Loading " << table << " did not complete.  " << rows << " rows inserted are "
+      << (journal_mode.empty() ? "rolled back." : "kept, since the journal is off; import the table again.");
+   LoggerNS::Logger::Log(ss.str());
+   Finish(journal_mode.empty() ? "Rollback Transaction;" : "Commit Transaction;");
+}
+
+// End the load's transaction with sql, and restore the journal
+bool BulkLoader::Finish(const char* sql) {
+   sqlite3_finalize(insert);                                // Release the statement so the transaction can end
+   insert = NULL;
+   const bool result(!sql || db->ExecuteSQL(sql));
+   if (!result) LoggerNS::Logger::Log(std::string("Unable to end loading ") + table);
+   if (!journal_mode.empty()) Pragma(db->db,std::string("PRAGMA journal_mode = ") + journal_mode + ";");
+   journal_mode.clear();
+   return result;
+}
+
+bool BulkLoader::Clear() {
+   return insert && db->ExecuteSQL(std::string("Delete from ") + table + ";");
+}
+
+// Insert every row of the same table in an attached database
+bool BulkLoader::CopyFrom(const std::string& schema) {
+   if (!insert) return false;
+   const std::string sql(std::string("Insert into ") + table + " (" + column_list + ") Select " + column_list + " From " + schema + "." + table + ";");
+   if (!db->ExecuteSQL(sql)) return false;
+   rows += static_cast<size_t>(sqlite3_changes(db->db));
+   return true;
+}
+
+// Except compares whole tables by sorting them, so the differing identities are found without an index on either
+bool BulkLoader::MergeFrom(const std::string& schema,const std::vector<std::string>& identity,const std::string& changes) {
+   if (!insert || identity.empty()) return false;
+   const std::string staged(schema + "." + table);
+   const std::string identity_list(ColumnList(identity));
+   const bool found(
+      db->ExecuteSQL(std::string("Drop Table If Exists temp.") + changes + ";") &&
+      db->ExecuteSQL(std::string("Create Temp Table ") + changes + " As Select " + identity_list + " From " + staged +
+                     " Except Select " + identity_list + " From main." + table + ";") &&
+      db->ExecuteSQL(std::string("Insert into temp.") + changes + " Select " + identity_list + " From main." + table +
+                     " Except Select " + identity_list + " From " + staged + ";") &&
+      db->ExecuteSQL(std::string("Create Index temp.") + changes + "_identity On " + changes + " (" + identity_list + ");"));
+   if (!found) return false;
+   // A changed row's old identity is in main, and its new one in schema, so it is deleted and inserted again
+   if (!db->ExecuteSQL(std::string("Delete from main.") + table + " Where Exists (Select 1 From temp." + changes + " c Where " +
+                       Matching(identity,"c",table) + ");")) return false;
+   deleted += static_cast<size_t>(sqlite3_changes(db->db));
+   if (!db->ExecuteSQL(std::string("Insert into main.") + table + " (" + column_list + ") Select " + column_list + " From " + staged +
+                       " s Where Exists (Select 1 From temp." + changes + " c Where " + Matching(identity,"c","s") + ");")) return false;
+   rows += static_cast<size_t>(sqlite3_changes(db->db));
+   return true;
+}
+
+bool BulkLoader::Insert(const boost::string_ref* fields,size_t count) {
+   if (!insert) return false;
+   while (count > column_count && fields[count-1].empty()) --count;    // A trailing tab adds an empty field
+   if (count > column_count) {
+      std::stringstream ss;
+      ss << table << " has " << column_count << " columns; a row to load has " << count << " fields.";
+      LoggerNS::Logger::Log(ss.str());
+      ++failures;
+      return false;
+   }
+   for (size_t i = 0; i < column_count; ++i) {
+      const boost::string_ref field(i < count ? fields[i] : boost::string_ref());
+      // A null pointer would bind NULL, so empty fields bind "".  Fields need only outlive the step.
+      sqlite3_bind_text(insert,static_cast<int>(i+1),field.empty() ? "" : field.data(),static_cast<int>(field.length()),SQLITE_STATIC);
+   }
+   const bool result(sqlite3_step(insert) == SQLITE_DONE);
+   sqlite3_reset(insert);
+   if (result) {
+      ++rows;
+   } else {
+      ++failures;
+      LoggerNS::Logger::Log(std::string("Unable to load a row into ") + table + ": " + sqlite3_errmsg(db->db));
+   }
+   return result;
+}
+
+bool BulkLoader::Commit() {
+   return insert && Finish("Commit Transaction;");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "db_capublic.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <boost/weak_ptr.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief BulkLoader replaces a capublic table's rows with those of its leg site .dat file.
+///        One Insert is prepared for the table and each row's fields are bound to it as they are, so no SQL text is
+///        built or parsed per row.  The whole load -- the Delete and every Insert -- is one explicit transaction,
+///        committed by Commit and rolled back if the loader is destroyed first.
+///        CopyFrom fills the table from a copy loaded into another database instead (see DatImport.h), and MergeFrom
+///        brings the table up to date with such a copy, rewriting only the rows that differ.
+///        For fresh imports, unjournaled turns off the rollback journal for the load.  That is faster still, but a load
+///        that fails part way cannot be rolled back, and leaves the table to be imported again.
+//*****************************************************************************
+//
+
+class BulkLoader {
+public:
+   BulkLoader(boost::weak_ptr<DB_capublic> database, const std::string& table, const std::vector<std::string>& columns, bool unjournaled);
+   ~BulkLoader();
+   bool   Ready() const    { return insert != NULL; }
+   bool   Clear();                                    // Delete the table's rows, within the load
+   // Insert one row.  fields are in column order; columns past the last field are empty, as in the .dat files.
+   bool   Insert(const boost::string_ref* fields, size_t count);
+   template <size_t N> bool Insert(const boost::string_ref (&fields)[N]) { return Insert(fields,N); }
+   bool   Insert(const std::vector<boost::string_ref>& fields) { return Insert(fields.data(),fields.size()); }
+   // Insert every row of the same table in the database attached as schema
+   bool   CopyFrom(const std::string& schema);
+   // Delete the rows the same table in schema lacks, and insert those it adds, comparing only the identity columns.
+   // The identities of the rows deleted and inserted are left in the temp table changes.
+   bool   MergeFrom(const std::string& schema, const std::vector<std::string>& identity, const std::string& changes);
+   bool   Commit();
+   size_t Rows()     const { return rows;     }       // Rows inserted
+   size_t Failures() const { return failures; }       // Rows not inserted
+   size_t Deleted()  const { return deleted;  }       // Rows deleted by MergeFrom
+private:
+   bool   Finish(const char* sql);
+   boost::shared_ptr<DB_capublic> db;
+   const std::string              table;
+   const std::string              column_list;        // The columns, separated by commas
+   const size_t                   column_count;
+   sqlite3_stmt*                  insert;
+   std::string                    journal_mode;       // The journal mode to restore, if the load turned it off
+   size_t                         rows;
+   size_t                         failures;
+   size_t                         deleted;
+};
@@ -1,4 +1,10 @@
+#include <BillProfileScores.h>
 #include <BillRowTable.h>
+#include <BillScoreWriter.h>
+#include <BillTermCounts.h>
+#include <BillWordIndex.h>
+#include <DatImport.h>
+#include <RankingCache.h>
 #include "CAPublic.h"
 #include "capublic_bill_history_tbl.h"
 #include "capublic_bill_version_authors_tbl.h"
@@ -10,13 +16,19 @@
 
 #include <boost/weak_ptr.hpp>
 #include <sstream>
+#include <vector>
 
 namespace {
    const std::string database_location("../Data/capublic.db");
+   const size_t score_batch_size(1000);                               // Bill scores per commit, unless changed with BillScoreBatchSize
 }
 
-CAPublic::CAPublic()                      : import_leg_data(true)             { Initialize(database_location); }
-CAPublic::CAPublic(bool _import_leg_data) : import_leg_data(_import_leg_data) { Initialize(database_location); }
+CAPublic::CAPublic()                      : import_leg_data(true),             unjournaled_import(false), incremental_import(false) { Initialize(database_location); }
+CAPublic::CAPublic(bool _import_leg_data) : import_leg_data(_import_leg_data), unjournaled_import(false), incremental_import(false) { Initialize(database_location); }
+CAPublic::CAPublic(bool _import_leg_data,bool _unjournaled_import,bool _incremental_import)
+   : import_leg_data(_import_leg_data), unjournaled_import(_unjournaled_import), incremental_import(_incremental_import) {
+   Initialize(database_location);
+}
 
 void CAPublic::Initialize(const std::string& databaseName) {
    ScopedElapsedTime elapsed_time("Initializing database","Database initialization run time: ");
@@ -28,6 +40,28 @@ void CAPublic::Initialize(const std::string& databaseName) {
    bill_version_authors_tbl = new capublic_bill_version_authors_tbl(wp,import_leg_data);
    bill_row_tbl             = new BillRowTable                     (wp,import_leg_data);
    location_code_tbl        = new capublic_location_code_tbl       (wp,import_leg_data);
+   if (import_leg_data) {
+      // The leg site tables are independent, so their .dat files are imported concurrently
+      std::vector<DatImport> imports;
+      imports.push_back(bill_history_tbl->Import());           // The largest first, so it starts first
+      imports.push_back(bill_version_tbl->Import());
+      imports.push_back(bill_version_authors_tbl->Import());
+      imports.push_back(bill_tbl->Import());
+      imports.push_back(location_code_tbl->Import());
+      CAPublicTablesNS::ImportDatFiles(wp,imports,unjournaled_import,incremental_import);
+   } else {
+      // Databases imported before the tables were indexed are indexed on first use
+      CAPublicTablesNS::CreateIndexes(wp,bill_tbl->Import());
+      CAPublicTablesNS::CreateIndexes(wp,bill_history_tbl->Import());
+      CAPublicTablesNS::CreateIndexes(wp,bill_version_tbl->Import());
+      CAPublicTablesNS::CreateIndexes(wp,bill_version_authors_tbl->Import());
+      CAPublicTablesNS::CreateIndexes(wp,location_code_tbl->Import());
+   }
+   bill_word_index          = new BillWordIndex                    (wp,import_leg_data);
+   bill_term_counts         = new BillTermCounts                   (wp,import_leg_data);
+   bill_score_writer        = new BillScoreWriter                  (wp,score_batch_size);
+   ranking_cache            = new RankingCache                     (wp,import_leg_data);
+   bill_profile_scores      = new BillProfileScores                (wp,import_leg_data);
 }
 
 bool CAPublic::ExecuteSQL(const std::string& command) {
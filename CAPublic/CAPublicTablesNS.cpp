@@ -3,10 +3,15 @@
 /// \brief This namespace collects methods that are useful for all capublic table processing.
 //*****************************************************************************
 //
+#include "BulkLoader.h"
 #include "CAPublicTablesNS.h"
+#include "DatFile.h"
 #include "DB_capublic.h"
+#include <Logger.h>
+#include "MappedFile.h"
 #include "sqlite3.h"
 
+#include <boost/filesystem/path.hpp>
 #include <boost/weak_ptr.hpp>
 #include <algorithm>
 #include <fstream>
@@ -18,10 +23,8 @@
 namespace CAPublicTablesNS {
 
    std::string ReadFile(const std::string& path) {
-      std::ifstream is(path);
-      std::stringstream ss;
-      ss << is.rdbuf();
-      return ss.str();
+      const MappedFile file(path);
+      return std::string(file.Data(),file.Size());
    }
 
    std::string TrimFirstLastSingleQuote(const std::string& source) { 
@@ -52,6 +55,37 @@ namespace CAPublicTablesNS {
       return true;
    }
 
+   //
+   //*****************************************************************************
+   /// \brief Replace a table's rows with those of its leg site .dat file, in one transaction.
+   ///        Each row's fields go from the mapped file straight to the table's prepared Insert.
+   ///        A file that can't be read leaves the table as it was.
+   //*****************************************************************************
+   //
+   bool ImportDatFile(boost::weak_ptr<DB_capublic> database, const std::string& path, const std::string& table_name,
+                      const std::vector<std::string>& columns, bool unjournaled) {
+      boost::shared_ptr<DB_capublic> wp = database.lock();
+      if (!wp) return false;
+      DatFile file(path);
+      if (!file.IsOpen()) {
+         LoggerNS::Logger::Log(std::string("Unable to read ") + path + ", so " + table_name + " is unchanged");
+         return false;
+      }
+      BulkLoader loader(database,table_name,columns,unjournaled);
+      if (!loader.Clear()) {
+         LoggerNS::Logger::Log(std::string("Unable to clear ") + table_name);
+         return false;
+      }
+      std::vector<boost::string_ref> fields;
+      while (file.NextRow(fields)) loader.Insert(fields);
+      const bool result(loader.Commit());
+      std::stringstream ss;
+      ss << "\t" << boost::filesystem::path(path).filename().string() << " has " << loader.Rows() + loader.Failures() << " rows, "
+         << loader.Failures() << " of which could not be loaded.";
+      LoggerNS::Logger::Log(ss.str());
+      return result;
+   }
+
    //
    //*****************************************************************************
    /// \brief Report exceptions
@@ -11,6 +11,8 @@ typedef std::vector<TableRow>    TableRowSet;
 
 namespace CAPublicTablesNS {
    bool        ClearTable(boost::weak_ptr<DB_capublic> db, const std::string& table_name);
+   bool        ImportDatFile(boost::weak_ptr<DB_capublic> db, const std::string& path, const std::string& table_name,
+                             const std::vector<std::string>& columns, bool unjournaled);
    TableRowSet ParseRowsToVector(std::string file_contents, TableRow& row);
    void        ReadFields(const std::string& source, size_t& trailing_offset, std::vector<std::string *>& results);
    std::string ReadFile(const std::string& path);
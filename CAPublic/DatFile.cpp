@@ -0,0 +1,38 @@
+#include "DatFile.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+   const char backtick(0x60);
+
+   boost::string_ref Unquoted(const char* begin,const char* end) {
+      boost::string_ref result(begin,end - begin);
+      if (!result.empty() && result.front() == backtick && result.back() == backtick) {
+         result = result.size() >= 2 ? result.substr(1,result.size() - 2) : boost::string_ref();
+      }
+      return result;
+   }
+}
+
+bool DatFile::NextRow(std::vector<boost::string_ref>& fields) {
+   fields.clear();
+   while (pos < end) {
+      const char* eol(static_cast<const char*>(memchr(pos,'\n',end - pos)));
+      const char* const next(eol ? eol + 1 : end);
+      if (!eol) eol = end;
+      if (eol > pos && *(eol-1) == '\r') --eol;                          // CR LF line ending
+      const char* field(pos);
+      pos = next;
+      if (eol == field) continue;                                        // Blank line
+      for (;;) {
+         const char* const tab(static_cast<const char*>(memchr(field,'\t',eol - field)));
+         fields.push_back(Unquoted(field,tab ? tab : eol));
+         if (!tab) break;
+         field = tab + 1;
+      }
+      return true;
+   }
+   return false;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief DatFile reads a leg site .dat file one row at a time, without copying it.
+///        The file is memory mapped (see MappedFile.h).  Each line is a row, and its fields are separated by tabs.
+///        A field enclosed in backticks has them removed, as CAPublicTablesNS::TrimFirstLastSingleQuote does.
+///        Fields refer into the mapped file, so they stay valid as long as the DatFile does.
+///        Lines and fields are found with memchr, which the C runtime scans for 16 or more bytes at a time.
+//*****************************************************************************
+//
+
+class DatFile : private boost::noncopyable {
+public:
+   explicit DatFile(const std::string& path) : file(path), pos(file.Data()), end(file.Data() + file.Size()) {}
+   bool   IsOpen() const { return file.IsOpen(); }
+   size_t Size()   const { return file.Size(); }
+   // Fill fields with the next row's fields, answering false after the last row.  Blank lines are skipped.
+   bool   NextRow(std::vector<boost::string_ref>& fields);
+private:
+   const MappedFile file;
+   const char*      pos;                              // Start of the next line
+   const char*      end;
+};
@@ -0,0 +1,199 @@
+#include <boost/thread/thread.hpp>
+#include <DatImport.h>
+#include "BulkLoader.h"
+#include "CAPublicTablesNS.h"
+#include "db_capublic.h"
+#include <Logger.h>
+#include <Readers.h>
+#include <ScopedElapsedTime.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   const std::string sql_create_changed_bills(
+      "CREATE TABLE IF NOT EXISTS changed_bills ("
+      "bill_id TEXT NOT NULL PRIMARY KEY"
+      ");"
+   );
+
+   boost::posix_time::ptime Now() { return boost::posix_time::microsec_clock::universal_time(); }
+
+   // A table loaded into its staging database
+   struct Staged {
+      size_t                            import;         // Offset into the imports
+      bool                              loaded;
+      boost::posix_time::time_duration  elapsed;
+      Staged(size_t i, bool l, boost::posix_time::time_duration e) : import(i), loaded(l), elapsed(e) {}
+   };
+
+   std::string StagingPath(sqlite3* db,const std::string& table_name) {
+      const char* main_path(sqlite3_db_filename(db,"main"));
+      return std::string(main_path && *main_path ? main_path : "capublic.db") + "." + table_name + ".staging";
+   }
+
+   void RemoveStaging(const std::string& staging_path) {
+      boost::system::error_code ec;
+      boost::filesystem::remove(staging_path,ec);
+   }
+
+   // Load a .dat file into a staging database of its own.  It is discarded once copied, so it is never journaled or synced.
+   bool Stage(const DatImport& import,const std::string& staging_path) {
+      RemoveStaging(staging_path);
+      boost::shared_ptr<DB_capublic> staging(new DB_capublic(staging_path));
+      return staging->ExecuteSQL("PRAGMA synchronous = OFF;") && staging->ExecuteSQL(import.create_sql) &&
+             CAPublicTablesNS::ImportDatFile(staging,import.path,import.table_name,import.columns,true);
+   }
+
+   // e.g. bill_tbl_measure_type_measure_num
+   std::string IndexName(const std::string& table_name,const std::string& columns) {
+      std::string result(table_name);
+      for (const char* p = columns.c_str(); *p; ++p) {
+         if (*p == ',') result += '_';
+         else if (*p != ' ') result += *p;
+      }
+      return result;
+   }
+
+   bool DropIndexes(boost::shared_ptr<DB_capublic> wp,const DatImport& import) {
+      bool result(true);
+      for (size_t i = 0; i < import.indexes.size(); ++i) {
+         result = wp->ExecuteSQL(std::string("DROP INDEX IF EXISTS ") + IndexName(import.table_name,import.indexes[i]) + ";") && result;
+      }
+      return result;
+   }
+
+   // The temp table holding the identities of the rows an incremental import changed in the table
+   std::string ChangesTable(const DatImport& import) { return import.table_name + "_changes"; }
+
+   // Replace the table's rows with those of its staged copy, or merge the copy into them, in one transaction.
+   // With the journal off, a copy that fails once begun cannot be rolled back, and leaves the table partly loaded.
+   bool CopyStaged(boost::shared_ptr<DB_capublic> wp,const DatImport& import,const std::string& staging_path,bool unjournaled,bool incremental,
+                   bool& partly_loaded) {
+      partly_loaded = false;
+      const unsigned long initial_row_count(wp->Count(import.table_name,""));
+      if (!wp->ExecuteSQL(std::string("ATTACH DATABASE ") + DB_capublic::Quote(staging_path) + " AS staging;")) return false;
+      bool result(false);
+      std::stringstream ss;
+      {  BulkLoader loader(wp,import.table_name,import.columns,unjournaled);
+         const bool begun(loader.Ready());
+         if (incremental) {
+            std::vector<std::string> identity(import.key);
+            identity.push_back(import.updated);
+            result = loader.MergeFrom("staging",identity,ChangesTable(import)) && loader.Commit();
+            ss << "\t" << import.table_name << " had " << initial_row_count << " rows.  " << loader.Deleted() << " were changed or removed, "
+               << loader.Rows() << " changed or added, and it now has " << wp->Count(import.table_name,"") << ".";
+         } else {
+            // Indexes are built once the rows are in, rather than updated as each is inserted
+            result = DropIndexes(wp,import) && loader.Clear() && loader.CopyFrom("staging") && loader.Commit();
+            ss << "\t" << import.table_name << " had " << initial_row_count << " rows, and now has " << wp->Count(import.table_name,"") << ".";
+         }
+         partly_loaded = !result && begun && unjournaled;
+      }
+      wp->ExecuteSQL("DETACH DATABASE staging;");
+      const boost::posix_time::ptime start(Now());
+      if (!CAPublicTablesNS::CreateIndexes(wp,import)) ss << "  Unable to index it.";
+      ss << "  Indexing time: " << Now() - start;
+      LoggerNS::Logger::Log(ss.str());
+      return result;
+   }
+
+   // Replace changed_bills with the bills of the rows the import changed.  Run once every table is merged, so a row
+   // may find its bill through another table, as an author does through bill_version_tbl.
+   bool RecordChangedBills(boost::shared_ptr<DB_capublic> wp,const std::vector<DatImport>& imports,const std::vector<bool>& merged) {
+      if (!wp->ExecuteSQL(sql_create_changed_bills) || !wp->ExecuteSQL("Begin Transaction;")) return false;
+      bool result(wp->ExecuteSQL("Delete from changed_bills;"));
+      for (size_t i = 0; i < imports.size(); ++i) {
+         const std::string& bill_id(imports[i].bill_id);
+         if (result && merged[i] && !bill_id.empty()) {
+            result = wp->ExecuteSQL(std::string("Insert Or Ignore into changed_bills (bill_id) Select ") + bill_id +
+                                    " From temp." + ChangesTable(imports[i]) + " r Where " + bill_id + " Is Not Null;");
+         }
+      }
+      result = wp->ExecuteSQL(result ? "Commit Transaction;" : "Rollback Transaction;") && result;
+      for (size_t i = 0; i < imports.size(); ++i) wp->ExecuteSQL(std::string("Drop Table If Exists temp.") + ChangesTable(imports[i]) + ";");
+      std::stringstream ss;
+      if (result) ss << "\t" << wp->Count("changed_bills","") << " bills changed.";
+      else        ss << "\tUnable to record the bills that changed.";
+      LoggerNS::Logger::Log(ss.str());
+      return result;
+   }
+}
+
+bool CAPublicTablesNS::ImportDatFiles(boost::weak_ptr<DB_capublic> database,const std::vector<DatImport>& imports,bool unjournaled,bool incremental) {
+   ScopedElapsedTime elapsed_time("Importing leg site data","Leg site data import time: ");
+   boost::shared_ptr<DB_capublic> wp = database.lock();
+   if (!wp) return false;
+   std::vector<std::string> staging_paths;
+   for (size_t i = 0; i < imports.size(); ++i) staging_paths.push_back(StagingPath(wp->db,imports[i].table_name));
+
+   // Each file is staged on a thread of its own
+   boost::mutex              mutex;
+   boost::condition_variable staged_ready;
+   std::deque<Staged>        staged;                   // Guarded by mutex
+   boost::thread_group       loaders;
+   for (size_t i = 0; i < imports.size(); ++i) {
+      loaders.create_thread([&,i]() {
+         const boost::posix_time::ptime start(Now());
+         const bool loaded(Stage(imports[i],staging_paths[i]));
+         boost::unique_lock<boost::mutex> lock(mutex);
+         staged.push_back(Staged(i,loaded,Now() - start));
+         staged_ready.notify_one();
+      });
+   }
+
+   // Staged tables are copied into capublic.db in the order they finish
+   bool result(true);
+   std::vector<bool> merged(imports.size(),false);
+   for (size_t copied = 0; copied < imports.size(); ++copied) {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      while (staged.empty()) staged_ready.wait(lock);
+      const Staged next(staged.front());
+      staged.pop_front();
+      lock.unlock();
+
+      const DatImport& import(imports[next.import]);
+      const boost::posix_time::ptime start(Now());
+      bool partly_loaded(false);
+      const bool imported(next.loaded && CopyStaged(wp,import,staging_paths[next.import],unjournaled,incremental,partly_loaded));
+      merged[next.import] = imported;
+      std::stringstream ss;
+      ss << "\t" << import.table_name;
+      if (imported)           ss << " imported";
+      else if (partly_loaded) ss << " not imported, and is left partly loaded, since the journal was off.  Import it again";
+      else                    ss << " not imported, and is unchanged";
+      ss << ".  Staging time: " << next.elapsed << ", copy time: " << Now() - start;
+      LoggerNS::Logger::Log(ss.str());
+      RemoveStaging(staging_paths[next.import]);
+      result = result && imported;
+   }
+   loaders.join_all();
+   // After a full import every bill may have changed, so none is singled out
+   if (incremental) result = RecordChangedBills(wp,imports,merged) && result;
+   else             result = wp->ExecuteSQL(sql_create_changed_bills) && wp->ExecuteSQL("Delete from changed_bills;") && result;
+   return result;
+}
+
+bool CAPublicTablesNS::CreateIndexes(boost::weak_ptr<DB_capublic> database,const DatImport& import) {
+   boost::shared_ptr<DB_capublic> wp = database.lock();
+   if (!wp) return false;
+   bool result(true);
+   for (size_t i = 0; i < import.indexes.size(); ++i) {
+      result = wp->ExecuteSQL(std::string("CREATE INDEX IF NOT EXISTS ") + IndexName(import.table_name,import.indexes[i]) +
+                              " ON " + import.table_name + " (" + import.indexes[i] + ");") && result;
+   }
+   return result;
+}
+
+std::vector<bill_id_t> CAPublicTablesNS::ChangedBills(boost::weak_ptr<DB_capublic> database) {
+   boost::shared_ptr<DB_capublic> wp = database.lock();
+   if (!wp || !wp->ExecuteSQL(sql_create_changed_bills)) return std::vector<bill_id_t>();
+   return Readers::ReadVectorString(database,"Select bill_id From changed_bills Order By bill_id;");
+}
@@ -0,0 +1,125 @@
+#include <QueryPlanAudit.h>
+#include "db_capublic.h"
+#include <Logger.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/shared_ptr.hpp>
+#include <ctype.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   bool IsWordChar(char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+   // The statement with each string and number literal replaced by ?
+   std::string Shape(const char* sql) {
+      std::string result;
+      for (const char* p = sql; *p; ) {
+         if (*p == '\'') {
+            for (++p; *p; ++p) {
+               if (*p != '\'') continue;
+               if (p[1] != '\'') { ++p; break; }
+               ++p;                                                        // '' is a quote within the literal
+            }
+            result += '?';
+         } else if (isdigit(static_cast<unsigned char>(*p)) && (result.empty() || !IsWordChar(result.back()))) {
+            while (IsWordChar(*p) || *p == '.') ++p;
+            result += '?';
+         } else {
+            result += *p++;
+         }
+      }
+      return result;
+   }
+
+   // Only statements that read rows have a plan worth auditing
+   bool IsQuery(const char* sql) {
+      while (isspace(static_cast<unsigned char>(*sql))) ++sql;
+      const std::string start(sql,strnlen(sql,8));
+      return boost::istarts_with(start,"select") || boost::istarts_with(start,"update") || boost::istarts_with(start,"delete") ||
+             boost::istarts_with(start,"insert") || boost::istarts_with(start,"with");
+   }
+
+   // e.g. "SCAN TABLE bill_version_tbl", rather than "SEARCH TABLE bill_version_tbl USING INDEX ..." or "SCAN SUBQUERY 1"
+   bool IsTableScan(const std::string& detail) {
+      return boost::starts_with(detail,"SCAN ") && detail.find("INDEX") == std::string::npos &&
+             detail.find("SUBQUERY") == std::string::npos && detail.find("CONSTANT ROW") == std::string::npos;
+   }
+
+   // The table scans in the statement's plan.  Answers false if the statement cannot be explained, as when it used a
+   // temp table since dropped.
+   bool TableScans(sqlite3* db,const std::string& sql,std::vector<std::string>& scans) {
+      sqlite3_stmt* explain(NULL);
+      const std::string explain_sql(std::string("EXPLAIN QUERY PLAN ") + sql);
+      if (sqlite3_prepare_v2(db,explain_sql.c_str(),-1,&explain,NULL) != SQLITE_OK) {
+         sqlite3_finalize(explain);
+         return false;
+      }
+      while (sqlite3_step(explain) == SQLITE_ROW) {
+         const char* detail(reinterpret_cast<const char*>(sqlite3_column_text(explain,3)));
+         if (detail && IsTableScan(detail)) scans.push_back(detail);
+      }
+      sqlite3_finalize(explain);
+      return true;
+   }
+}
+
+QueryPlanAudit::QueryPlanAudit(boost::weak_ptr<DB_capublic> database) : db_public(database) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp && sqlite3_trace_v2(wp->db,SQLITE_TRACE_STMT,&QueryPlanAudit::Trace,this) == SQLITE_OK) {
+      LoggerNS::Logger::Log("Recording queries, to audit their plans");
+   }
+}
+
+QueryPlanAudit::~QueryPlanAudit() {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) sqlite3_trace_v2(wp->db,0,NULL,NULL);
+}
+
+// Called by SQLite as each statement starts.  sqlite3_sql gives the statement's own text, even when sqlite3_exec ran several.
+int QueryPlanAudit::Trace(unsigned type,void* audit,void* statement,void* sql) {
+   if (type == SQLITE_TRACE_STMT) {
+      const char* text(sqlite3_sql(static_cast<sqlite3_stmt*>(statement)));
+      if (text) static_cast<QueryPlanAudit*>(audit)->Record(text);
+   }
+   return 0;
+}
+
+void QueryPlanAudit::Record(const char* sql) {
+   if (!IsQuery(sql)) return;
+   const std::string shape(Shape(sql));
+   boost::unique_lock<boost::mutex> lock(mutex);
+   Recorded& recorded(statements[shape]);
+   if (recorded.runs++ == 0) recorded.example = sql;
+}
+
+// Only statements with a Where clause are flagged.  One that reads every row, as ReadBillRows does, must scan.
+size_t QueryPlanAudit::Report() {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp) return 0;
+   std::map<std::string,Recorded> recorded;
+   {  boost::unique_lock<boost::mutex> lock(mutex);
+      recorded = statements;
+   }
+   size_t flagged(0),unexplained(0);
+   for (auto itr = recorded.begin(); itr != recorded.end(); ++itr) {
+      std::vector<std::string> scans;
+      if (!TableScans(wp->db,itr->second.example,scans)) {
+         ++unexplained;
+         continue;
+      }
+      if (scans.empty() || !boost::icontains(itr->first," where ")) continue;
+      ++flagged;
+      std::stringstream ss;
+      ss << "\tRun " << itr->second.runs << " times: " << itr->first;
+      for (size_t i = 0; i < scans.size(); ++i) ss << std::endl << "\t\t" << scans[i];
+      LoggerNS::Logger::Log(ss.str());
+   }
+   std::stringstream ss;
+   ss << "Query plan audit: " << recorded.size() << " queries, " << flagged << " of which scan a table";
+   if (unexplained > 0) ss << ".  " << unexplained << " could no longer be explained";
+   LoggerNS::Logger::Log(ss.str() + ".");
+   return flagged;
+}
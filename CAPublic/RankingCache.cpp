@@ -0,0 +1,81 @@
+#include <RankingCache.h>
+#include "db_capublic.h"
+#include <Logger.h>
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+
+namespace {
+   const std::string sql_create_ranking_cache_tbl(
+      "CREATE TABLE IF NOT EXISTS ranking_cache_tbl ("
+      "text_hash     TEXT    NOT NULL, "
+      "term_set_hash TEXT    NOT NULL, "
+      "neg_score     INTEGER NOT NULL, "
+      "pos_score     INTEGER NOT NULL, "
+      "counts        BLOB, "                                    // One 32-bit count per term
+      "PRIMARY KEY (text_hash, term_set_hash)"
+      ");"
+   );
+
+   sqlite3_stmt* Prepare(sqlite3* db,const char* sql) {
+      sqlite3_stmt* result(NULL);
+      if (sqlite3_prepare_v2(db,sql,-1,&result,NULL) != SQLITE_OK) {
+         LoggerNS::Logger::Log(std::string("RankingCache was unable to prepare ") + sql);
+         sqlite3_finalize(result);
+         result = NULL;
+      }
+      return result;
+   }
+}
+
+RankingCache::RankingCache(boost::weak_ptr<DB_capublic> database,bool import_leg_data) : db_public(database) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp && !wp->ExecuteSQL(sql_create_ranking_cache_tbl)) LoggerNS::Logger::Log("Unable to create ranking_cache_tbl");
+}
+
+// Every ranking stored for a term set
+std::map<std::string,CachedRanking> RankingCache::Read(const std::string& term_set_hash) {
+   std::map<std::string,CachedRanking> result;
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (wp) {
+      sqlite3_stmt* select(Prepare(wp->db,"Select text_hash, neg_score, pos_score, counts From ranking_cache_tbl Where term_set_hash = ?;"));
+      if (select) sqlite3_bind_text(select,1,term_set_hash.c_str(),-1,SQLITE_STATIC);
+      while (select && sqlite3_step(select) == SQLITE_ROW) {
+         const char* text_hash(reinterpret_cast<const char*>(sqlite3_column_text(select,0)));
+         if (!text_hash) continue;
+         CachedRanking& ranking(result[text_hash]);
+         ranking.neg_score = static_cast<score_t>(sqlite3_column_int(select,1));
+         ranking.pos_score = static_cast<score_t>(sqlite3_column_int(select,2));
+         const unsigned int* counts(static_cast<const unsigned int*>(sqlite3_column_blob(select,3)));
+         ranking.counts.assign(counts,counts + sqlite3_column_bytes(select,3) / sizeof(unsigned int));
+      }
+      sqlite3_finalize(select);
+   }
+   return result;
+}
+
+// Store a text's ranking.  A savepoint lets the write join a batch the score writer has open.
+bool RankingCache::Write(const std::string& text_hash,const std::string& term_set_hash,const CachedRanking& ranking) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   if (!wp || !wp->ExecuteSQL("Savepoint ranking_cache;")) return false;
+   sqlite3_stmt* insert(Prepare(wp->db,
+      "Insert Or Replace Into ranking_cache_tbl (text_hash, term_set_hash, neg_score, pos_score, counts) Values (?, ?, ?, ?, ?);"));
+   bool result(insert != NULL);
+   if (insert) {
+      sqlite3_bind_text(insert,1,text_hash.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_text(insert,2,term_set_hash.c_str(),-1,SQLITE_STATIC);
+      sqlite3_bind_int (insert,3,static_cast<int>(ranking.neg_score));
+      sqlite3_bind_int (insert,4,static_cast<int>(ranking.pos_score));
+      sqlite3_bind_blob(insert,5,ranking.counts.empty() ? NULL : &ranking.counts[0],static_cast<int>(ranking.counts.size() * sizeof(unsigned int)),SQLITE_STATIC);
+      result = sqlite3_step(insert) == SQLITE_DONE;
+   }
+   sqlite3_finalize(insert);
+   wp->ExecuteSQL(result ? "Release ranking_cache;" : "Rollback To ranking_cache; Release ranking_cache;");
+   return result;
+}
+
+// Drop the rankings of every other term set
+bool RankingCache::Prune(const std::string& term_set_hash) {
+   boost::shared_ptr<DB_capublic> wp = db_public.lock();
+   return wp && wp->ExecuteSQL(std::string("Delete From ranking_cache_tbl Where term_set_hash <> ") + DB_capublic::Quote(term_set_hash) + ";");
+}
@@ -36,15 +36,12 @@ class capublic_bill_tbl : abstract_table {
 public:
    capublic_bill_tbl(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
    ~capublic_bill_tbl() {}
+   DatImport Import() const;
    std::vector<BillRow> capublic_bill_tbl::Read();
    std::string MeasureType(const std::string& id);
    std::string MeasureNum(const std::string& id);
    std::string FieldQuery(const std::string& query);
 private:
-   void InsertBillTable(const std::string& path);
-   bool Insert(const BillTableRow& row,boost::weak_ptr<DB_capublic>& db_public);
-   void ParseAndWriteRow(const std::string& line,boost::weak_ptr<DB_capublic>& db_public);
-
    boost::weak_ptr<DB_capublic> db_public;
 };
 
@@ -23,11 +23,9 @@ class capublic_bill_version_authors_tbl : abstract_table {
 public:
    capublic_bill_version_authors_tbl(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
    ~capublic_bill_version_authors_tbl() {}
+   DatImport Import() const;
    std::string Author(const std::string& bill_ID);
 private:
-   void InsertBillAuthorsTable(const std::string& path);
-   bool Insert(const BillAuthorsTableRow& row);
-   void ParseAndWriteRow(const std::string& line,boost::weak_ptr<DB_capublic>& db_public);
    boost::weak_ptr<DB_capublic> db_public;
 };
 
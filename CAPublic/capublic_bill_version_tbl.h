@@ -38,6 +38,7 @@ class capublic_bill_version_tbl : abstract_table {
 public:
    capublic_bill_version_tbl(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
    ~capublic_bill_version_tbl() {}
+   DatImport Import() const;
    bool Insert(const BillVersionTableRow& row);
    std::string BillIDFromLob(const std::string& lob);
    std::string Title(const std::string& lob);
@@ -48,9 +49,5 @@ public:
    std::vector<BillRow> Read(const std::vector<std::string>& selection)  { return Readers::ReadVectorVersionIdTbl(db_public,selection); }
 
    private:
-   void InsertBillVersionTable(const std::string& path);
-   bool Insert(const BillVersionTableRow& row,boost::weak_ptr<DB_capublic>& db_public);
-   void ParseAndWriteRow(const std::string& line,boost::weak_ptr<DB_capublic>& db_public);
-
    boost::weak_ptr<DB_capublic> db_public;
 };
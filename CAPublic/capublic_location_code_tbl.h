@@ -22,11 +22,8 @@ class capublic_location_code_tbl : abstract_table {
 public:
    capublic_location_code_tbl(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
    ~capublic_location_code_tbl() {}
+   DatImport Import() const;
    std::string FieldQuery(const std::string& query);
 private:
-   bool Insert(const LocationTableRow& row);
-   void InsertLocationTable(const std::string& path);
-   void ParseAndWriteRow(const std::string& line,boost::weak_ptr<DB_capublic>& db_public);
-
    boost::weak_ptr<DB_capublic> db_public;
 };
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+#include <string>
+#include <vector>
+
+// A bill version's scores under one ranking profile
+struct ProfileScore {
+   std::string profile;                   // <name> of the <profile>
+   score_t     neg_score;
+   score_t     pos_score;
+   ProfileScore(const std::string& p, score_t n, score_t s) : profile(p), neg_score(n), pos_score(s) {}
+};
+
+//
+//*****************************************************************************
+/// \brief BillProfileScores persists each bill version's scores under the ranking profiles listed in the configuration.
+///        The scores of the configuration's own negative and positive files stay in BillRows.
+//*****************************************************************************
+//
+
+class BillProfileScores {
+public:
+   BillProfileScores(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
+   ~BillProfileScores() {}
+   bool Write(const bill_ver_id_t& bill_version_id, const std::vector<ProfileScore>& scores);
+   bool Retain(const std::vector<std::string>& profiles);
+private:
+   boost::weak_ptr<DB_capublic> db_public;
+};
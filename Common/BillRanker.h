@@ -2,6 +2,7 @@
 
 #include <BillRow.h>
 #include "CAPublic.h"
+#include "Configuration.h"
 #include <boost/weak_ptr.hpp>
 #include <string>
 #include <vector>
@@ -17,5 +18,8 @@ namespace BillRanker {
       unsigned int word_score;
    };
 
-   std::vector<BillRanking> GenerateBillRankings(std::vector<BillRow>& bills,CAPublic& db,const std::string positive, const std::string negative);
+   // Profile 0 is ranked into the bills' own scores; further profiles are ranked in the same pass into bill_profile_score_tbl
+   std::vector<BillRanking> GenerateBillRankings(std::vector<BillRow>& bills,CAPublic& db,const std::vector<RankingProfile>& profiles, unsigned int threads, bool amendment_delta);
+   // Falls back to GenerateBillRankings, on threads, if there are phrase terms, which the word index can't count
+   std::vector<BillRanking> GenerateBillRankingsFromIndex(std::vector<BillRow>& bills,CAPublic& db,const std::vector<RankingProfile>& profiles, unsigned int threads);
 }
@@ -1,13 +1,18 @@
 #include "BillRankerUtilities.h"
 #include "Database/DB.h"
 #include "LegInfo.h"
+#include "Logger.h"
+#include "MappedFile.h"
 #include "Performer.h"
+#include "RankingTermFile.h"
+#include "Tokenizer.h"
 //
 #include <boost/algorithm/string.hpp>
-#include <boost/asio.hpp>
-#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/thread.hpp>
 
@@ -20,16 +25,10 @@
 #include <time.h>
 #include <vector>
 
-typedef std::map<std::string, std::pair<std::regex, int>> RankWordMap;
-typedef std::map<std::string, std::pair<std::regex, int>> RankPhraseMap;
-typedef RankWordMap::iterator RankWordItr;
-typedef RankWordMap::const_iterator RankWordCItr;
-typedef std::vector<std::string> WordVector;
-typedef std::vector<std::string>::const_iterator WordItr;
+using BillRankerUtilities::RankingTerm;
+using BillRankerUtilities::RankingPlan;
 
 namespace {
-   int score;                          // Accumulate the bill's score
-
    // Convert a string to lower case.
    std::string ToLowerCase(const std::string& source) {
       std::string result(source);
@@ -37,223 +36,205 @@ namespace {
       return result;
    }
 
-   // Fill a vector with the search terms (sorted) contained in rankingTerms.
-   void AlphabetizedListOfRankingTerms(const RankWordMap rankingTerms, WordVector& rankingStrings) {
-      rankingStrings.clear();
-      rankingStrings.reserve(rankingTerms.size());
-      std::for_each(rankingTerms.begin(), rankingTerms.end(), [&](const std::pair<std::string, std::pair<std::regex, int>>& item) {
-         rankingStrings.push_back(item.first);
-      });
-      std::sort(rankingStrings.begin(),rankingStrings.end(), [&](const std::string& a, const std::string& b) -> bool { 
-         const std::string a_lower_case(ToLowerCase(a));
-         const std::string b_lower_case(ToLowerCase(b));
-         return a_lower_case.compare(b_lower_case) < 0; 
-      });
-   }
-
-   // Fill a vector with the words in a string.
-   void TokenizeStringIntoVector(const std::string& source, WordVector& words) {
-      const std::regex splitOn("[^\\w]+");
-      std::sregex_token_iterator itr(source.begin(), source.end(), splitOn, -1);
-      const std::sregex_token_iterator endOfSequence;
-      words.clear();
-      words.reserve(250000);                             // TODO: Pass this value
-      while (itr != endOfSequence) {
-         const auto token((*itr++).str());               // Need string, not sub_match
-         if (token.length() > 0) words.push_back(token);
-      }
-   }
-
-   // Convert vector contents to lower case and then sort the vector 
-   // /arg words - the vector to convert.  On exit the vector is converted.
-   void MakeLowercaseAndSortedInPlace(WordVector& words) {
-      // Transform the strings in the vector
-      std::transform(words.begin(), words.end(), words.begin(), [](std::string str) -> std::string { 
-         return ToLowerCase(str);
-      });
-      std::sort(words.begin(),words.end());
-   }
-
    // Search through the words vector for the first instance of a term in the ranking terms
-   // /arg r_start - looking for a match for this term
-   // /arg w_start - start searching the words vector at this point
-   // /arg w_end   - stop  searching the words vector at this point
-   std::vector<std::string>::const_iterator FindFirstMatch(
-      const std::regex& want_match, std::vector<std::string>::const_iterator w_start,std::vector<std::string>::const_iterator w_end) 
+   // /arg want_match - looking for a match for this term
+   // /arg w_start    - start searching the words vector at this point
+   // /arg w_end      - stop  searching the words vector at this point
+   TokenVector::const_iterator FindFirstMatch(
+      const RankingTerm& want_match, TokenVector::const_iterator w_start, TokenVector::const_iterator w_end) 
    {
-      std::smatch m;
-      return std::find_if(w_start, w_end, 
-         [&](const std::string& item) { return std::regex_search(item,m,want_match);
-      });
+      return std::find_if(w_start, w_end, [&](const Token& item) { return want_match.Matches(item); });
    }
 
    // Count words vector matches to a term in the ranking terms
-   // /arg r_start - looking for a match for this term
-   // /arg w_start - follows first match in the words vector
-   // /arg w_end   - stop  searching the words vector at this point
+   // /arg want_match - looking for a match for this term
+   // /arg w_start    - follows first match in the words vector
+   // /arg w_end      - stop  searching the words vector at this point
    unsigned int CountMatches(
-      const std::regex& want_match, std::vector<std::string>::const_iterator w_start, std::vector<std::string>::const_iterator w_end) 
+      const RankingTerm& want_match, TokenVector::const_iterator w_start, TokenVector::const_iterator w_end) 
    {
-      std::smatch m;
       // Count matches, stopping on the first term that doesn't match.
-      const std::vector<std::string>::const_iterator w_first_match(w_start);
-      const std::vector<std::string>::const_iterator w_first_non_match(std::find_if(w_start, w_end, 
-         [&](const std::string& item) { return !std::regex_search(item,m,want_match);
-      }));
+      const TokenVector::const_iterator w_first_match(w_start);
+      const TokenVector::const_iterator w_first_non_match(std::find_if(w_start, w_end, 
+         [&](const Token& item) { return !want_match.Matches(item); }));
 
       // Return count of matches (one already found before entering this function)
-      return std::distance(w_first_match,w_first_non_match);
+      return static_cast<unsigned int>(std::distance(w_first_match,w_first_non_match));
+   }
+
+   // A persistent pool of threads that share out the terms of one ranking job at a time.  The calling thread counts too.
+   // Each thread takes the next uncounted term and stores its count in that term's own slot, so no lock guards the counts;
+   // the caller adds them up once every term is counted.  The text is shared, read only, by every thread.
+   class TermPool {
+   public:
+      explicit TermPool(unsigned int threads);
+      ~TermPool();
+      unsigned int Threads() const { return static_cast<unsigned int>(helpers.size()) + 1; }
+      // Count the non-overlapping matches of each regex in text.  counts[i] is the count of regexes[i].
+      void Count(const std::string& text, const std::vector<const std::regex*>& regexes, std::vector<unsigned int>& counts);
+   private:
+      void Run();
+      void CountTerms();
+      boost::thread_group                  helpers;
+      boost::mutex                         mutex;                // Guards handing out jobs, not the counts
+      boost::condition_variable            job_ready;
+      boost::condition_variable            job_done;
+      unsigned long                        job;                  // Incremented for each job
+      unsigned int                         busy;                 // Helpers still counting the current job
+      bool                                 stopping;
+      const std::string*                   text;
+      const std::vector<const std::regex*>* regexes;
+      std::vector<unsigned int>*           counts;
+      boost::atomic<size_t>                next;                 // Next term to count
+   };
+
+   TermPool::TermPool(unsigned int threads) : job(0), busy(0), stopping(false), text(NULL), regexes(NULL), counts(NULL), next(0) {
+      for (unsigned int i = 1; i < threads; ++i) helpers.create_thread([this]() { Run(); });
+   }
+
+   TermPool::~TermPool() {
+      {  boost::unique_lock<boost::mutex> lock(mutex);
+         stopping = true;
+      }
+      job_ready.notify_all();
+      helpers.join_all();
+   }
+
+   void TermPool::CountTerms() {
+      for (size_t i = next++; i < regexes->size(); i = next++) {
+         (*counts)[i] = static_cast<unsigned int>(std::distance(std::sregex_iterator(text->begin(),text->end(),*(*regexes)[i]),std::sregex_iterator()));
+      }
    }
 
-   typedef std::pair<std::string, std::pair<std::regex, int>> RANKING_TERM_TYPE;
+   void TermPool::Run() {
+      unsigned long done(0);
+      for (;;) {
+         {  boost::unique_lock<boost::mutex> lock(mutex);
+            while (!stopping && job == done) job_ready.wait(lock);
+            if (stopping) return;
+            done = job;
+         }
+         CountTerms();
+         boost::unique_lock<boost::mutex> lock(mutex);
+         if (--busy == 0) job_done.notify_one();
+      }
+   }
 
-   void RankByPhraseSubr2(unsigned int& match_count, std::string& s2, std::smatch& m) {
-         match_count++;
-         s2 = m.suffix().str();
+   void TermPool::Count(const std::string& source, const std::vector<const std::regex*>& terms, std::vector<unsigned int>& result) {
+      result.assign(terms.size(),0);
+      {  boost::unique_lock<boost::mutex> lock(mutex);
+         text = &source;
+         regexes = &terms;
+         counts = &result;
+         next = 0;
+         busy = static_cast<unsigned int>(helpers.size());
+         ++job;
+      }
+      job_ready.notify_all();
+      CountTerms();
+      boost::unique_lock<boost::mutex> lock(mutex);
+      while (busy > 0) job_done.wait(lock);
    }
 
-   void RankByPhraseSubr(const std::string& source, const RANKING_TERM_TYPE& entry) {
-      unsigned int match_count(0);
-      std::string s2(source);
-      std::smatch m;
-      while (std::regex_search(s2,m,entry.second.first)) {
-         RankByPhraseSubr2(match_count,s2,m);
+   boost::mutex pool_mutex;                                          // Guards sizing the pool, and each of its jobs
+
+   // The pool, sized on first use by timing the first job on each thread count up to the number of cores.
+   // More threads are not always faster -- memory bandwidth, not the processor, can bound regex searches.
+   // Called with pool_mutex held.
+   TermPool& CalibratedPool(const std::string& text, const std::vector<const std::regex*>& regexes) {
+      static boost::scoped_ptr<TermPool> pool;
+      if (pool) return *pool;
+      const unsigned int cores(std::max(1u,boost::thread::hardware_concurrency()));
+      const unsigned int most(std::min<unsigned int>(cores,static_cast<unsigned int>(regexes.size())));
+      boost::posix_time::time_duration best;
+      std::vector<unsigned int> counts;
+      for (unsigned int threads = 1; threads <= std::max(1u,most); ++threads) {
+         boost::scoped_ptr<TermPool> candidate(new TermPool(threads));
+         const boost::posix_time::ptime start(boost::posix_time::microsec_clock::universal_time());
+         candidate->Count(text,regexes,counts);
+         const boost::posix_time::time_duration elapsed(boost::posix_time::microsec_clock::universal_time() - start);
+         if (!pool || elapsed < best) {
+            pool.swap(candidate);
+            best = elapsed;
+         }
       }
+      std::stringstream ss;
+      ss << "Counting phrases on " << pool->Threads() << " threads, the fastest of 1 to " << std::max(1u,most);
+      LoggerNS::Logger::Log(ss.str());
+      return *pool;
+   }
+
+   // Add a phrase's matches to the score
+   void ScorePhrase(const RankingTerm& entry, unsigned int match_count, int& score) {
       if (match_count > 0) {
-         const unsigned int worth(match_count * entry.second.second);
+         const unsigned int worth(match_count * entry.score);
          score += worth;
-         std::cout << "   " << match_count << " instances of " << entry.first 
-            << " (" << entry.second.second << ")"
+         std::cout << "   " << match_count << " instances of " << entry.key 
+            << " (" << entry.score << ")"
             << ", worth = " << worth 
             << ", score = " << score 
             << std::endl;
       }
    }
 
-   void RankByPhrase(const std::string& source, const RankPhraseMap& phraseRankingTerms, bool showDetails) {
+   // Count each phrase's non-overlapping matches on the term pool, then score them in the order of the terms
+   int RankByPhrase(const std::string& source, const std::vector<RankingTerm>& phrases, bool showDetails) {
+      int score(0);
       std::cout << "Phrase count" << std::endl;
-      if (phraseRankingTerms.size() > 0) {
-         std::for_each(phraseRankingTerms.begin(), phraseRankingTerms.end(), [&](const RANKING_TERM_TYPE& entry) {
-            RankByPhraseSubr(source,entry);
-         });
+      if (phrases.size() > 0) {
+         std::vector<const std::regex*> regexes;
+         regexes.reserve(phrases.size());
+         std::for_each(phrases.begin(), phrases.end(), [&](const RankingTerm& entry) { regexes.push_back(&entry.rx); });
+         std::vector<unsigned int> counts;
+         // The pool's threads share one job at a time, so callers ranking at once take turns
+         boost::unique_lock<boost::mutex> lock(pool_mutex);
+         CalibratedPool(source,regexes).Count(source,regexes,counts);
+         for (size_t i = 0; i < phrases.size(); ++i) ScorePhrase(phrases[i],counts[i],score);
       }
+      return score;
    }
 
-   void RankByWord(const std::string& source, const RankWordMap& wordRankingTerms, bool showDetails) {
+   // The word terms are already in case-insensitive alphabetical order, so the sorted words are searched in one sweep
+   int RankByWord(const std::string& source, const std::vector<RankingTerm>& terms, bool showDetails) {
+      int score(0);
       std::cout << "Word count" << std::endl;
-                  // 0) Sort ranking terms in alphabetical order
-      WordVector rankingStrings;
-      AlphabetizedListOfRankingTerms(wordRankingTerms,rankingStrings);
 
-      // 1) Collect all words into a vector
-      const boost::posix_time::ptime now1 = boost::posix_time::microsec_clock::universal_time();
-      WordVector words;
-      TokenizeStringIntoVector(source,words);
+      // 1) Collect all words into a vector.  The words refer into source.
+      TokenVector words;
+      Tokenizer::Tokenize(source,words);
 
-      // 2) Make vector contents lower case and then sort the vector
-      //MakeLowercaseAndSortedInPlace(words);
+      // 2) Sort the vector
       std::sort(words.begin(),words.end());
 
       // 3) Search through the words vector for each instance of a term in the ranking terms
-      std::vector<std::string>::const_iterator current_words_starting_point(words.cbegin());
-      // rankingStrings and lower_case_rankingStrings differ only in case
-      std::for_each(rankingStrings.begin(), rankingStrings.end(), [&](const std::string& ranking_str) {
-         if (current_words_starting_point != words.cend()) {
-            const RankWordCItr looking_for(wordRankingTerms.find(ranking_str));
-            if (looking_for != wordRankingTerms.end()) {
-               const std::regex want_match(looking_for->second.first);
-               std::vector<std::string>::const_iterator w_itr = FindFirstMatch(want_match, current_words_starting_point, words.cend());
-               if (w_itr == words.cend()) {
-                  //std::cout << "   No match for " << ranking_str << std::endl; 
-               } else {
-                  // 4) Increment score by number-of-matches time match-value
-                  unsigned int match_count(CountMatches(want_match, w_itr, words.cend()));
-                  const unsigned int worth(match_count * looking_for->second.second);
-                  score += worth;
-                  std::cout << "   " << match_count << " instances of " << ranking_str 
-                     << " (" << looking_for->second.second << ")"
-                     << ", worth = " << worth 
-                     << ", score = " << score 
-                     << std::endl;
-                  current_words_starting_point = w_itr + match_count;
-               }
-            }
+      TokenVector::const_iterator current_words_starting_point(words.cbegin());
+      for (auto term = terms.begin(); term != terms.end() && current_words_starting_point != words.cend(); ++term) {
+         TokenVector::const_iterator w_itr = FindFirstMatch(*term, current_words_starting_point, words.cend());
+         if (w_itr != words.cend()) {
+            // 4) Increment score by number-of-matches time match-value
+            unsigned int match_count(CountMatches(*term, w_itr, words.cend()));
+            const unsigned int worth(match_count * term->score);
+            score += worth;
+            std::cout << "   " << match_count << " instances of " << term->key 
+               << " (" << term->score << ")"
+               << ", worth = " << worth 
+               << ", score = " << score 
+               << std::endl;
+            current_words_starting_point = w_itr + match_count;
          }
-      });
-   }
-}
-
-// Define the argument passed to each worker thread's Run method
-struct WorkerArgs {
-   const std::string textToProcess; // Making this a reference nearly halves the speed (double the time) for AB383
-   const std::regex re;
-   const int value;
-   WorkerArgs(const std::string& f, const std::regex& t, int v) : textToProcess(f), re(t), value(v) { }
-};
-
-// Conceptually, spawn one worker thread to process each member of rankingTerms and let them run in parallel.
-// Practically, that gives poor performance, so limit the number of threads that run concurrently.
-// By observation, processing each rankingTerms member serially is faster than processing all in parallel on the current hardware.
-// Note that each rankingTerms member defines a WorkerArgs.
-class Workers {
-public:
-   Workers(int numberOfThreads, const std::string& textToProcess, const RankWordMap rankingTerms, bool _showDetails)
-       : showDetails(_showDetails)
-    {
-      // By test, 2 threads has been found to be faster than 3 threads, which is slower than 1 thread (!)
-      // Recheck this when the hardware is next upgraded.
-      //
-      // Also tested extracting all textToProcess matches to terms in rankingTerms and then adding up the value for each match.
-      // Extracting the matches is incredibly slow -- a matter of hours.  The approach below is demonstrably fastest.
-      const unsigned int max_concurrent_threads(2);
-      auto itr(rankingTerms.cbegin());             // std::map<std::string, std::pair<std::regex, int>>::const_iterator
-      std::for_each(rankingTerms.cbegin(),rankingTerms.cend(), [&] (const std::pair<std::string, std::pair<std::regex, int>> term) { 
-         const WorkerArgs w(textToProcess, term.second.first, term.second.second);
-         m_threads.create_thread(boost::bind(&Workers::Run, this, w));
-         if (m_threads.size() % max_concurrent_threads == 0) m_threads.join_all();
-      });
-   }
-   ~Workers() {
-      m_io.stop();
-      m_threads.join_all();
-   }
-   void Run(const WorkerArgs w) {
-      //showDetails = true;
-      //if (showDetails) std::cout <<  w.re << " started." << std::endl;
-      //const boost::posix_time::ptime now1 = boost::posix_time::microsec_clock::universal_time();
-      const std::ptrdiff_t match_count(std::distance(
-         std::sregex_iterator(w.textToProcess.cbegin(), w.textToProcess.cend(), w.re), 
-         std::sregex_iterator()));
-      if (match_count > 0) {
-         //if (showDetails) {
-         //   std::stringstream ss;
-         //   const boost::posix_time::ptime now2 = boost::posix_time::microsec_clock::universal_time();
-         //   const boost::posix_time::time_duration dur = now2 - now1;
-         //   ss << " Count=" << match_count << ", value=" << w.value << ", Ranking time = " << dur << std::endl;
-         //   std::cout << ss.str();
-         //}
-         boost::unique_lock<boost::mutex> lock(mut_score);
-         score += match_count * w.value;
       }
+      return score;
    }
-
-   boost::asio::io_service m_io;
-private:
-   boost::thread_group m_threads;
-   bool showDetails;
-   boost::mutex mut_score;             // Single-threaded access to the bill's score
-};
+}
 
 //
 //*****************************************************************************
 /// \brief Rank a single file.
 /// \brief fileName -- rank this file
-/// \brief wordRankingTerms -- define the value of each search term
-/// \brief phraseRankingTerms -- define the value of each search phrase
+/// \brief plan -- the compiled search terms and phrases, and the value of each
 //*****************************************************************************
 //
-int BillRankerUtilities::Rank(const std::string& fileName, const RankWordMap& wordRankingTerms, 
-                                                           const RankPhraseMap& phraseRankingTerms, bool showDetails) {
+int BillRankerUtilities::Rank(const std::string& fileName, const RankingPlan& plan, bool showDetails) {
    std::string source(ReadFile(fileName));         // Read the file in.
    // Remove standard bill prefix, including Legislative Counsel's digest
    const std::string exp("THE PEOPLE OF THE STATE OF CALIFORNIA DO ENACT AS FOLLOWS:\n");
@@ -261,16 +242,13 @@ int BillRankerUtilities::Rank(const std::string& fileName, const RankWordMap& wo
    if (splitHere != source.npos) source = std::string(source.c_str()+splitHere+exp.length());
    // In particular, remove \r\n from the bill text.  Remove everything less than space.
    std::for_each(source.begin(),source.end(), [](char& c) { if (c < ' ') c = ' '; });
-   return RankText(source,wordRankingTerms,phraseRankingTerms,showDetails);
+   return RankText(source,plan,showDetails);
 }
 
-int BillRankerUtilities::RankText(const std::string& source, 
-                                  const RankWordMap& wordRankingTerms, const RankPhraseMap& phraseRankingTerms,
-                                  bool showDetails) {
-   score = 0;
+int BillRankerUtilities::RankText(const std::string& source, const RankingPlan& plan, bool showDetails) {
    const boost::posix_time::ptime now1 = boost::posix_time::microsec_clock::universal_time();
-   RankByWord  (source, wordRankingTerms,   showDetails);
-   RankByPhrase(source, phraseRankingTerms, showDetails);
+   const int score(RankByWord  (source, plan.words,   showDetails) +
+                   RankByPhrase(source, plan.phrases, showDetails));
    const boost::posix_time::ptime now2 = boost::posix_time::microsec_clock::universal_time();
    const boost::posix_time::time_duration dur = now2 - now1;
    std::cout << "Ranking time = " << dur << std::endl;
@@ -284,80 +262,51 @@ int BillRankerUtilities::RankText(const std::string& source,
 //*****************************************************************************
 //
 std::string BillRankerUtilities::ReadFile(const std::string& fileName) {
-   std::ifstream is(fileName);
-   std::stringstream ss;
-   ss << is.rdbuf();
-   return ss.str();
+   const MappedFile file(fileName);
+   return std::string(file.Data(),file.Size());
 }
 //
 //*****************************************************************************
-/// \brief Read the ranking terms from the XML file that defines them.
-///        This is very simple code that does no error checking and is not production quality.
-/// \brief fileName -- path to file containing ranking terms
+/// \brief A ranking term: its regex is compiled, its key lowered, and it is classified for TermPattern, once.
+///        Terms TermPattern can classify are matched without the regex.
 //*****************************************************************************
 //
-namespace {
-   std::string ExtractTerm(const std::string& matchElement, const std::string& regexString) {
-      const std::regex rx(regexString);
-      const std::string fmt("$1");
-      return std::regex_replace(matchElement,rx,fmt);
-   }
-
-   std::string SingleLine(std::string& source) {
-      std::for_each(source.begin(),source.end(),[](char& c) { if (c <= ' ') c = ' '; }); // Multiline not supported by std::regex
-      return source;
-   }
+BillRankerUtilities::RankingTerm::RankingTerm(const std::string& k, const std::string& pattern, int s) 
+   : key(k), lower_key(ToLowerCase(k)), rx(pattern, std::regex::icase), matcher(pattern), score(s) {
+}
 
-   std::vector<std::string> ExtractRawTerms(const std::string& fileName, const std::regex& rx) {
-      std::vector<std::string> result;
-      std::string source(SingleLine(BillRankerUtilities::ReadFile(fileName)));   // Read the file into a string
-      std::smatch matches;
-      while (std::regex_search(source, matches, rx)) {
-         const std::string member(matches[0]);                       // Current match
-         result.push_back(member);
-         source = matches.suffix().str();                            // Prepare for the next substring match
-      }
-      return result;
-   }
+bool BillRankerUtilities::RankingTerm::Matches(boost::string_ref word) const {
+   if (matcher.Classification() != TermPattern::Regex) return matcher.Matches(word);
+   return std::regex_search(word.begin(),word.end(),rx);
+}
 
-   RankWordMap ExtractRankingTerms(const std::vector<std::string>& rawTerms, const std::regex& rx) {
-      RankWordMap result;
-      std::for_each(rawTerms.begin(), rawTerms.end(), [&](std::string source) {
-         std::smatch matches;
-         std::string keyMember, regexMember;                         // Save Key and Regex tuple members here
-         while (std::regex_search(source, matches, rx)) {
-            const std::string member(matches[0]);                    // Cycles through Key, Regex, and Score
-            // This is a Key definition, save the string
-            if (member.find("Key") != std::string::npos) { keyMember = ExtractTerm(member,"<Key>(.*?)</Key>");
-            // This is a Regex definition, save the string
-            } else if (member.find("Regex") != std::string::npos) { regexMember = ExtractTerm(member,"<Regex>(.*?)</Regex>");
-            // This is a Score definition, have all three members, build the map entry
-            } else {
-               const std::string score = ExtractTerm(member,"<Score>(.*?)</Score>");
-               std::stringstream ss2;
-               ss2 << score;
-               int intScore;
-               ss2 >> intScore;
-               const std::regex rx(regexMember, std::regex::icase);
-               result[keyMember] = std::make_pair(rx,intScore);
-            }
-            // Prepare for the next substring match
-            source = matches.suffix().str();
-         }
+//
+//*****************************************************************************
+/// \brief Read the ranking terms from the XML file that defines them, or from its cache (see RankingTermFile.h),
+///        and compile them into a plan, with the word terms in the order RankByWord searches for them.
+/// \brief fileName -- path to file containing ranking terms
+//*****************************************************************************
+//
+namespace {
+   // Compile each key's regex and score, in key order.  A later definition of a key replaces an earlier one.
+   std::vector<RankingTerm> CompileRankingTerms(const std::vector<TermDefinition>& definitions) {
+      std::map<std::string, const TermDefinition*> latest;
+      std::for_each(definitions.begin(),definitions.end(),[&](const TermDefinition& definition) { latest[definition.key] = &definition; });
+      std::vector<RankingTerm> result;
+      result.reserve(latest.size());
+      std::for_each(latest.begin(),latest.end(),[&](const std::pair<const std::string, const TermDefinition*>& entry) {
+         result.push_back(RankingTerm(entry.first,entry.second->regex,entry.second->score));
       });
       return result;
    }
 }
 
-void BillRankerUtilities::ReadRankingTerms(const std::string& fileName, std::map<std::string, std::pair<std::regex, int>>& wordMap, 
-                                                                        std::map<std::string, std::pair<std::regex, int>>& phraseMap) {
-   const std::regex rx1("<Pair>.*?</Pair>");
-   const std::regex rx2("<Phrase>.*?</Phrase>");
-   const std::regex rx3("<Key>.*?</Key>|<Regex>.*?</Regex>|<Score>.*?</Score>");
-   const std::vector<std::string> pairs1(ExtractRawTerms(fileName,rx1));
-   const std::vector<std::string> pairs2(ExtractRawTerms(fileName,rx2));
-   wordMap   = ExtractRankingTerms(pairs1,rx3);
-   phraseMap = ExtractRankingTerms(pairs2,rx3);
+void BillRankerUtilities::ReadRankingTerms(const std::string& fileName, RankingPlan& plan) {
+   const RankingTermFile terms(RankingTermFiles::Load(fileName));
+   plan.words   = CompileRankingTerms(terms.pairs);
+   plan.phrases = CompileRankingTerms(terms.phrases);
+   // Keys differing only in case keep their key order
+   std::stable_sort(plan.words.begin(),plan.words.end(),[](const RankingTerm& a, const RankingTerm& b) { return a.lower_key < b.lower_key; });
 }
 //
 //*****************************************************************************
@@ -2,17 +2,36 @@
 #define BillRankerUtilities_h
 
 #include "Database/DB.h"
+#include "TermPattern.h"
 #include <boost/optional.hpp>
 
 #include <map>
 #include <regex>
 #include <string>
+#include <vector>
 
 namespace BillRankerUtilities {
-   int         Rank    (const std::string& fileName, const std::map<std::string, std::pair<std::regex, int>>&,
-                                                     const std::map<std::string, std::pair<std::regex, int>>&, bool showDetails);
-   int         RankText(const std::string& source,   const std::map<std::string, std::pair<std::regex, int>>&, 
-                                                     const std::map<std::string, std::pair<std::regex, int>>&, bool showDetails);
+   // A ranking term, compiled once when the terms are read
+   struct RankingTerm {
+      std::string key;
+      std::string lower_key;                          // The key in lower case, the order word terms are matched in
+      std::regex  rx;
+      TermPattern matcher;                            // Confirms literal, prefix and suffix terms without the regex
+      int         score;
+      RankingTerm(const std::string& k, const std::string& pattern, int s);
+      bool Matches(boost::string_ref word) const;
+   };
+
+   // Every ranking term of a file, prepared by ReadRankingTerms and then shared, read only, by every bill and thread
+   struct RankingPlan {
+      std::vector<RankingTerm> words;                 // Sorted by lower case key
+      std::vector<RankingTerm> phrases;               // Sorted by key
+   };
+
+   // Safe to call on several threads at once.  Phrases are counted on one shared pool of threads, so concurrent
+   // calls take turns counting them.
+   int         Rank    (const std::string& fileName, const RankingPlan& plan, bool showDetails);
+   int         RankText(const std::string& source,   const RankingPlan& plan, bool showDetails);
    std::string ReadFile(const std::string& fileName);
    void        EvaluateRowLatestSetAndClear(DB& db, const std::string& table, const std::string& measure, 
                                             boost::optional<unsigned int>& clearThis, boost::optional<unsigned int>& setThis);
@@ -21,8 +40,7 @@ namespace BillRankerUtilities {
    std::string FilenameForBill(DB& database, const std::string& bill);
    std::string RangeText(const std::string& bill);
    std::string TextFolder(const std::string& bill);
-   void ReadRankingTerms(const std::string& fileName, std::map<std::string, std::pair<std::regex, int>>& wordMap, 
-                                                      std::map<std::string, std::pair<std::regex, int>>& phraseMap);
+   void ReadRankingTerms(const std::string& fileName, RankingPlan& plan);
 }
 
 #endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <BillRow.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+
+//
+//*****************************************************************************
+/// \brief BillScoreWriter writes ranked bills' scores to BillRows through one prepared statement.
+///        Scores are committed in batches inside an explicit transaction, so a full re-rank costs a handful of
+///        commits instead of one per bill.  Flush commits whatever is pending; the destructor flushes,
+///        and so does CAPublic's destructor.
+//*****************************************************************************
+//
+
+class BillScoreWriter {
+public:
+   BillScoreWriter(boost::weak_ptr<DB_capublic> database, size_t batch_size);
+   ~BillScoreWriter() { Flush(); }
+   void   BatchSize(size_t size) { batch_size = size > 0 ? size : 1; }
+   bool   Write(const BillRow& row);
+   bool   Flush();
+   size_t Pending() const { return pending; }
+private:
+   bool Begin();
+   boost::weak_ptr<DB_capublic> db_public;
+   sqlite3_stmt*                update;
+   size_t                       batch_size;
+   size_t                       pending;                // Writes since the transaction began
+};
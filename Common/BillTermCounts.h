@@ -0,0 +1,63 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// Number of matches of one ranking term in one bill version
+struct TermCount {
+   std::string  term_key;                 // <Key> of the term's <Pair>
+   int          polarity;                 // TermSet::Polarity
+   unsigned int count;
+   TermCount(const std::string& k, int p, unsigned int c) : term_key(k), polarity(p), count(c) {}
+};
+
+// A ranking term as it was when bill versions were last counted
+struct RankingTermRecord {
+   std::string term_key;
+   int         polarity;
+   std::string hash;                       // Hash of what the term's counts depend on: its key and regex, and a word term's walk.  Scores aren't included, so weight changes keep their counts.
+   RankingTermRecord(const std::string& k, int p, const std::string& h) : term_key(k), polarity(p), hash(h) {}
+};
+
+// Change in a version's scores due to its amendments, from the scores of the version it amends
+struct AmendmentDelta {
+   bill_ver_id_t previous_version_id;
+   int           neg_delta;
+   int           pos_delta;
+   AmendmentDelta() : neg_delta(0), pos_delta(0) {}
+};
+
+//
+//*****************************************************************************
+/// \brief BillTermCounts persists each bill version's match count for every ranking term, so bills can be
+///        rescored without reading their text when ranking term scores change.
+///        Only non-zero counts are stored.  Every counted version has counts for every term in ranking_term_tbl;
+///        a version whose counts can't be brought up to date with the ranking terms is dropped from the counted set.
+///        Versions ranked from their amendments also record the score change due to those amendments, for BR.
+//*****************************************************************************
+//
+
+class BillTermCounts {
+public:
+   BillTermCounts(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
+   ~BillTermCounts() { Finalize(); }
+   std::vector<RankingTermRecord>                    RankingTerms();
+   bool                                              ReplaceRankingTerms(const std::vector<RankingTermRecord>& terms);
+   std::vector<bill_ver_id_t>                        CountedVersions();
+   std::map<bill_ver_id_t,std::vector<TermCount>>    Read();
+   bool                                              Write(const bill_ver_id_t& bill_version_id, const std::vector<TermCount>& counts);
+   bool                                              WriteAmendmentDelta(const bill_ver_id_t& bill_version_id, const AmendmentDelta& delta);
+   bool                                              Uncount(const std::vector<bill_ver_id_t>& bill_version_ids);
+   void                                              Finalize();      // Release Write's statements, so the connection can close
+private:
+   bool PrepareWrite(sqlite3* db);
+   boost::weak_ptr<DB_capublic> db_public;
+   sqlite3_stmt*                erase;                  // Write's statements, prepared on its first call and kept until Finalize
+   sqlite3_stmt*                insert;
+   sqlite3_stmt*                mark;
+};
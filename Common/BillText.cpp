@@ -0,0 +1,51 @@
+#include "BillText.h"
+#include "HtmlStripper.h"
+#include "MappedFile.h"
+
+#include <boost/filesystem/path.hpp>
+#include <string>
+
+namespace {
+   const std::string raw_lob_files_folder("D:/CCHR/2017-2018/LatestDownload/Bills");
+   // Standard bill prefix, ending Legislative Counsel's digest
+   const std::string enacting_clause("The people of the State of California do enact as follows:");
+}
+
+// Path to the lob file containing a bill version's text
+std::string BillText::LobPath(const std::string& lob) {
+   return (boost::filesystem::path(raw_lob_files_folder) / lob).string();
+}
+
+// Remove HTML from a string containing the text of a bill
+void BillText::RemoveHTML(std::string& contents) {
+   // Remove standard bill prefix, including Legislative Counsel's digest
+   const size_t splitHere(contents.find(enacting_clause));
+   if (splitHere != contents.npos) contents = std::string(contents.c_str()+splitHere+enacting_clause.length());
+   // Remove HTML, and everything less than space
+   HtmlStripper::Strip(contents,true);
+}
+
+// Read a lob file and remove its HTML.  The text after the standard prefix is stripped straight out of the mapped file.
+std::string BillText::ReadBillText(const std::string& lob_path) {
+   const MappedFile file(lob_path);
+   std::string result;
+   StripBillText(file.Contents(),result);
+   return result;
+}
+
+// Remove the standard prefix and the HTML from the contents of a lob file already in memory
+void BillText::StripBillText(boost::string_ref contents,std::string& result) {
+   HtmlStripper::TagVector tags;
+   StripBillText(contents,result,tags);
+}
+
+void BillText::StripBillText(boost::string_ref contents,std::string& result,HtmlStripper::TagVector& tags) {
+   const size_t splitHere(contents.find(enacting_clause));
+   HtmlStripper::Strip(splitHere == boost::string_ref::npos ? contents : contents.substr(splitHere+enacting_clause.length()),result,true,tags);
+}
+
+// The text the amendments of an amended bill insert and delete, without the standard prefix.  Answers false if the bill has no amendment markup.
+bool BillText::AmendmentText(boost::string_ref contents,std::string& inserted,std::string& deleted) {
+   const size_t splitHere(contents.find(enacting_clause));
+   return HtmlStripper::Amendments(splitHere == boost::string_ref::npos ? contents : contents.substr(splitHere+enacting_clause.length()),inserted,deleted);
+}
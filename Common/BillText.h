@@ -0,0 +1,22 @@
+#pragma once
+
+#include "HtmlStripper.h"
+
+#include <boost/utility/string_ref.hpp>
+#include <string>
+
+//
+//*****************************************************************************
+/// \brief BillText collects the preparation a bill's lob file needs before its words can be ranked or indexed.
+///        Ranking and the word index must prepare text identically, or their scores would disagree.
+//*****************************************************************************
+//
+
+namespace BillText {
+   std::string LobPath     (const std::string& lob);
+   void        RemoveHTML  (std::string& contents);
+   std::string ReadBillText(const std::string& lob_path);
+   void        StripBillText(boost::string_ref contents, std::string& result);
+   void        StripBillText(boost::string_ref contents, std::string& result, HtmlStripper::TagVector& tags);
+   bool        AmendmentText(boost::string_ref contents, std::string& inserted, std::string& deleted);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+#include <string>
+#include <vector>
+
+struct WordPosting {
+   bill_ver_id_t bill_version_id;
+   unsigned int  count;
+   WordPosting(const bill_ver_id_t& id, unsigned int c) : bill_version_id(id), count(c) {}
+};
+
+struct WordCount {
+   std::string  word;
+   unsigned int count;
+   WordCount(const std::string& w, unsigned int c) : word(w), count(c) {}
+};
+
+//
+//*****************************************************************************
+/// \brief BillWordIndex is an inverted index of the words in each bill version's lob file.
+///        It maps every word, as cased in the text, to the bill versions containing it, with the number of occurrences,
+///        so changed ranking terms can be scored without reading the lob files again.  Word terms are counted over
+///        the sorted words of a bill (see TermSet.h), and the order of words depends on their case, so case is kept.
+///        The index is brought up to date when leg site data is imported.  Only lob files not already
+///        indexed are read.
+//*****************************************************************************
+//
+
+class BillWordIndex {
+public:
+   BillWordIndex(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
+   ~BillWordIndex() {}
+   void                       Update();
+   std::vector<std::string>   Words();
+   std::vector<bill_ver_id_t> IndexedVersions();
+   std::vector<WordPosting>   Postings(const std::string& word);
+   std::vector<WordCount>     Words(const bill_ver_id_t& bill_version_id);
+private:
+   bool IndexVersion(const bill_ver_id_t& bill_version_id, const bill_lob_t& lob);
+   boost::weak_ptr<DB_capublic> db_public;
+};
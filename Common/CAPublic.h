@@ -8,14 +8,22 @@
 
 //#include <BillRanker.h>
 //#include <BillRow.h>
+#include <BillProfileScores.h>
 #include <BillRowTable.h>
+#include <BillScoreWriter.h>
+#include <BillTermCounts.h>
+#include <BillWordIndex.h>
+#include <QueryPlanAudit.h>
+#include <RankingCache.h>
 #include "capublic_bill_tbl.h"
 #include "capublic_bill_history_tbl.h"
 #include "capublic_bill_version_authors_tbl.h"
 #include "capublic_bill_version_tbl.h"
 #include "capublic_location_code_tbl.h"
 #include "DB_capublic.h"
+#include <DatImport.h>
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <string>
 
@@ -30,7 +38,11 @@ class CAPublic {
 public:
    CAPublic_API CAPublic();
    CAPublic_API CAPublic(bool _import_leg_data);
-   CAPublic_API ~CAPublic() {}
+   // unjournaled_import imports the leg site data with the rollback journal off.  Faster, but a table whose import fails is
+   // left partly loaded, and the import must be run again.
+   // incremental_import rewrites only the rows the leg site changed, and records their bills (see ChangedBills).
+   CAPublic_API CAPublic(bool _import_leg_data, bool _unjournaled_import, bool _incremental_import);
+   CAPublic_API ~CAPublic() { bill_score_writer->Flush(); bill_term_counts->Finalize(); }    // Scores still batched are committed, and statements released, on exit
    CAPublic_API bool ExecuteSQL(const std::string& command);
 
    CAPublic_API std::string Author          (const std::string& id)    { return bill_version_authors_tbl->Author(id); }
@@ -42,6 +54,9 @@ public:
    CAPublic_API std::string BillVersionField(const std::string& query) { return bill_version_tbl->FieldQuery(query);  }
    CAPublic_API std::string LocationField   (const std::string& query) { return location_code_tbl->FieldQuery(query); }
    CAPublic_API bool UpdateBillRow          (const BillRow& item)      { return bill_row_tbl->Update(item);           }
+   CAPublic_API bool WriteBillScores        (const BillRow& item)      { return bill_score_writer->Write(item);       }
+   CAPublic_API bool FlushBillScores        ()                         { return bill_score_writer->Flush();           }
+   CAPublic_API void BillScoreBatchSize     (size_t size)              { bill_score_writer->BatchSize(size);          }
 
    CAPublic_API std::vector<BillRow>                 ReadBillRows()           { return bill_row_tbl->Read();     }
    CAPublic_API             BillRow                  ReadSingleBillRow(const std::string& measure_type, const std::string& measure_num) { return bill_row_tbl->ReadSingleBillRow(measure_type,measure_num); }
@@ -49,18 +64,52 @@ public:
    CAPublic_API std::vector<std::string> ReadVectorString(const std::string& query)  { return Readers::ReadVectorString(WP(),query); }
    CAPublic_API std::vector<std::vector<std::string>> ReadVectorVector(const std::string& query)  { return Readers::ReadVectorVector(WP(),query); }
 
+   CAPublic_API std::vector<std::string>   IndexedWords()                         { return bill_word_index->Words();           }
+   CAPublic_API std::vector<bill_ver_id_t> IndexedBillVersions()                  { return bill_word_index->IndexedVersions(); }
+   CAPublic_API std::vector<WordPosting>   WordPostings(const std::string& word)  { return bill_word_index->Postings(word);    }
+   CAPublic_API std::vector<WordCount>     IndexedWords(const bill_ver_id_t& bill_version_id) { return bill_word_index->Words(bill_version_id); }
+
+   CAPublic_API std::vector<RankingTermRecord>                 StoredRankingTerms()  { return bill_term_counts->RankingTerms();    }
+   CAPublic_API std::vector<bill_ver_id_t>                     CountedBillVersions() { return bill_term_counts->CountedVersions(); }
+   CAPublic_API std::map<bill_ver_id_t,std::vector<TermCount>> ReadTermCounts()      { return bill_term_counts->Read();            }
+   CAPublic_API bool ReplaceStoredRankingTerms(const std::vector<RankingTermRecord>& terms)                      { return bill_term_counts->ReplaceRankingTerms(terms);    }
+   CAPublic_API bool WriteTermCounts(const bill_ver_id_t& bill_version_id, const std::vector<TermCount>& counts) { return bill_term_counts->Write(bill_version_id,counts); }
+   CAPublic_API bool WriteAmendmentDelta(const bill_ver_id_t& bill_version_id, const AmendmentDelta& delta)      { return bill_term_counts->WriteAmendmentDelta(bill_version_id,delta); }
+   CAPublic_API bool UncountBillVersions(const std::vector<bill_ver_id_t>& bill_version_ids)                     { return bill_term_counts->Uncount(bill_version_ids);     }
+
+   CAPublic_API bool WriteProfileScores(const bill_ver_id_t& bill_version_id, const std::vector<ProfileScore>& scores) { return bill_profile_scores->Write(bill_version_id,scores); }
+   CAPublic_API bool RetainProfileScores(const std::vector<std::string>& profiles)                                    { return bill_profile_scores->Retain(profiles);               }
+
+   CAPublic_API std::map<std::string,CachedRanking> ReadCachedRankings(const std::string& term_set_hash)   { return ranking_cache->Read(term_set_hash);  }
+   CAPublic_API bool PruneCachedRankings(const std::string& term_set_hash)                                  { return ranking_cache->Prune(term_set_hash); }
+   CAPublic_API bool WriteCachedRanking(const std::string& text_hash, const std::string& term_set_hash, const CachedRanking& ranking) {
+      return ranking_cache->Write(text_hash,term_set_hash,ranking);
+   }
+
+   CAPublic_API std::vector<bill_id_t> ChangedBills() { return CAPublicTablesNS::ChangedBills(WP()); }
    CAPublic_API std::vector<std::vector<std::string>> BillHistory(const std::string& bill_id) { return bill_history_tbl->BillHistory(bill_id); }
+   // Record the queries run from now on, so ReportQueryPlans can flag those that scan a table (see QueryPlanAudit.h)
+   CAPublic_API void   AuditQueryPlans()  { query_plan_audit.reset(new QueryPlanAudit(WP())); }
+   CAPublic_API size_t ReportQueryPlans() { return query_plan_audit ? query_plan_audit->Report() : 0; }
    CAPublic_API boost::weak_ptr<DB_capublic> WP() { return boost::weak_ptr<DB_capublic> (sp_capublic); }
 
 private:
    void Initialize(const std::string& databaseName);
    boost::shared_ptr<DB_capublic>     sp_capublic;
    bool                               import_leg_data;
+   bool                               unjournaled_import;
+   bool                               incremental_import;
    capublic_bill_tbl*                 bill_tbl;
    capublic_bill_history_tbl*         bill_history_tbl;
    capublic_bill_version_tbl*         bill_version_tbl;
    capublic_bill_version_authors_tbl* bill_version_authors_tbl;
    BillRowTable*                      bill_row_tbl;
    capublic_location_code_tbl*        location_code_tbl;
+   BillWordIndex*                     bill_word_index;
+   BillTermCounts*                    bill_term_counts;
+   BillScoreWriter*                   bill_score_writer;
+   RankingCache*                      ranking_cache;
+   BillProfileScores*                 bill_profile_scores;
+   boost::scoped_ptr<QueryPlanAudit>  query_plan_audit;
 };
 
@@ -5,6 +5,8 @@
 // Configuration_API functions as being imported from a DLL, whereas this DLL sees symbols
 // defined with this macro as being exported.
 
+#pragma once
+
 #ifdef Configuration_EXPORTS
 #define Configuration_API __declspec(dllexport)
 #else
@@ -12,6 +14,16 @@
 #endif
 
 #include <string> 
+#include <vector>
+
+// A <profile> under <keyword_files>: a named pair of RegexScore files, ranked alongside the negative and positive files
+struct RankingProfile {
+   std::string name;
+   std::string negative;
+   std::string positive;
+   RankingProfile() {}
+   RankingProfile(const std::string& n, const std::string& neg, const std::string& pos) : name(n), negative(neg), positive(pos) {}
+};
 
 class Configuration_API Configuration {
 public:
@@ -22,6 +34,7 @@ public:
    const std::string Negative();
    const std::string Password();
    const std::string Positive();
+   const std::vector<RankingProfile> Profiles();
    const std::string ResultsFolder();
    const std::string Site();
    const std::string User();
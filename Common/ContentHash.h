@@ -0,0 +1,18 @@
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// 64-bit FNV-1a hash.  Unlike std::hash, the value doesn't change from build to build, so it can be stored.
+inline unsigned long long ContentHash(boost::string_ref content,unsigned long long hash = 14695981039346656037ULL) {
+   for (size_t i = 0; i < content.length(); ++i) hash = (hash ^ static_cast<unsigned char>(content[i])) * 1099511628211ULL;
+   return hash;
+}
+
+inline std::string ContentHashText(unsigned long long hash) {
+   std::stringstream ss;
+   ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+   return ss.str();
+}
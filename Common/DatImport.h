@@ -0,0 +1,48 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief DatImport describes how a capublic table is imported from its leg site .dat file.
+///        ImportDatFiles imports several tables at once.  Each file is parsed and loaded on its own thread, into its
+///        own staging database beside capublic.db, so the loads share no connection and no lock.  As each staging
+///        database is complete, it is attached and its table copied over the table in capublic.db, in one transaction.
+///        The copies are made one at a time, while the larger files are still loading.
+///        An incremental import merges each staged table instead of copying it.  A row is identified by its key and its
+///        trans_update, so only rows that are new, changed or gone are written.  The bills they belong to are kept in
+///        changed_bills, for the steps that follow the import (see ChangedBills).
+///        The indexes lookups need are dropped before a full import and created once it is copied, so the load does
+///        not maintain them row by row.  An incremental import writes few rows, and keeps them.
+//*****************************************************************************
+//
+
+struct DatImport {
+   std::string              path;                     // The .dat file
+   std::string              table_name;
+   std::string              create_sql;               // Creates the table, in the staging database too
+   std::vector<std::string> columns;                  // In the order of the .dat file's fields
+   std::vector<std::string> key;                      // The columns identifying a row
+   std::string              updated;                  // The column the leg site sets when it changes a row
+   std::string              bill_id;                  // The bill of a changed row r, as an expression of its key.  Empty if none.
+   std::vector<std::string> indexes;                  // The columns of each index lookups use, e.g. "measure_type, measure_num"
+   DatImport(const std::string& p, const std::string& t, const std::string& c, const std::vector<std::string>& cols,
+             const std::vector<std::string>& k, const std::string& u, const std::string& b, const std::vector<std::string>& i)
+      : path(p), table_name(t), create_sql(c), columns(cols), key(k), updated(u), bill_id(b), indexes(i) {}
+};
+
+namespace CAPublicTablesNS {
+   // Answers false if any table could not be imported.  Tables that could not be imported are unchanged, except with
+   // unjournaled: a copy that fails once begun cannot be rolled back, leaves its table partly loaded, and is logged so.
+   // incremental merges each file into its table, rather than replacing the table's rows.
+   bool ImportDatFiles(boost::weak_ptr<DB_capublic> db, const std::vector<DatImport>& imports, bool unjournaled, bool incremental);
+   // Create the table's indexes that do not exist yet
+   bool CreateIndexes(boost::weak_ptr<DB_capublic> db, const DatImport& import);
+   // The bills changed by the last incremental import.  A full import leaves none, as every bill may have changed.
+   std::vector<bill_id_t> ChangedBills(boost::weak_ptr<DB_capublic> db);
+}
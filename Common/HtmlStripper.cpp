@@ -0,0 +1,188 @@
+#include "HtmlStripper.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define HTMLSTRIPPER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+   using namespace HtmlStripper;
+
+   bool IsLineEnd(char c) { return c == '\n' || c == '\r'; }
+
+#if HTMLSTRIPPER_SSE2
+   inline unsigned int LowestSetBit(unsigned int mask) {
+      unsigned int index(0);
+      while ((mask & 1) == 0) { mask >>= 1; ++index; }
+      return index;
+   }
+#endif
+
+   // Offset of the first '<' or line end at or after pos
+   size_t ScanMarkup(const char* text,size_t pos,size_t length) {
+#if HTMLSTRIPPER_SSE2
+      const __m128i open(_mm_set1_epi8('<')),lf(_mm_set1_epi8('\n')),cr(_mm_set1_epi8('\r'));
+      while (pos + 16 <= length) {
+         const __m128i bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text+pos)));
+         const __m128i found(_mm_or_si128(_mm_cmpeq_epi8(bytes,open),_mm_or_si128(_mm_cmpeq_epi8(bytes,lf),_mm_cmpeq_epi8(bytes,cr))));
+         const unsigned int mask(static_cast<unsigned int>(_mm_movemask_epi8(found)));
+         if (mask != 0) return pos + LowestSetBit(mask);
+         pos += 16;
+      }
+#endif
+      while (pos < length && text[pos] != '<' && !IsLineEnd(text[pos])) ++pos;
+      return pos;
+   }
+
+   bool At(const char* text,size_t pos,size_t length,const char* literal) {
+      const size_t n(strlen(literal));
+      return pos + n <= length && memcmp(text+pos,literal,n) == 0;
+   }
+
+   // Recognize the markup starting with the '<' at pos.  Answers the offset just past it, or 0 if there is none.
+   size_t MatchTag(const char* text,size_t pos,size_t length,TagType& type) {
+      if (At(text,pos,length,"<caml") || At(text,pos,length,"</caml")) {
+         for (size_t i = pos + 5; i < length && !IsLineEnd(text[i]); ++i) {
+            if (text[i] == '>') { type = Caml; return i + 1; }
+         }
+         return 0;
+      }
+      struct Literal { const char* text; TagType type; };
+      static const Literal literals[] = {
+         { "<em>", EmOpen }, { "</em>", EmClose }, { "<strike>", StrikeOpen }, { "</strike>", StrikeClose }, { "<p>", POpen }, { "</p>", PClose }
+      };
+      for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); ++i) {
+         if (At(text,pos,length,literals[i].text)) { type = literals[i].type; return pos + strlen(literals[i].text); }
+      }
+      // <span class=.EnSpace./> -- each . is any character but a line end
+      const size_t enspace_length(23);
+      if (pos + enspace_length <= length && At(text,pos,length,"<span class=") && !IsLineEnd(text[pos+12]) &&
+          At(text,pos+13,length,"EnSpace") && !IsLineEnd(text[pos+20]) && At(text,pos+21,length,"/>")) {
+         type = EnSpace;
+         return pos + enspace_length;
+      }
+      return 0;
+   }
+
+   // Find every tag.  Scanning resumes after each tag, as std::regex_replace resumes after each match.
+   void FindTags(const char* text,size_t length,std::vector<Tag>& tags) {
+      tags.clear();
+      unsigned int line(0);
+      size_t pos(ScanMarkup(text,0,length));
+      while (pos < length) {
+         TagType type;
+         size_t end(0);
+         if (IsLineEnd(text[pos])) ++line;
+         else end = MatchTag(text,pos,length,type);
+         if (end > 0) tags.push_back(Tag(type,pos,end,line));
+         pos = ScanMarkup(text,end > 0 ? end : pos + 1,length);
+      }
+   }
+
+   // Pair each opening tag with the nearest closing tag after it on the same line, as a lazy regex match would.
+   // Tags already dropped are no longer in the text, so they are skipped.
+   void PairTags(std::vector<Tag>& tags,TagType open_type,TagType close_type,Action paired) {
+      const size_t none(tags.size());
+      size_t open(none);
+      for (size_t i = 0; i < tags.size(); ++i) {
+         Tag& tag(tags[i]);
+         if (tag.action == Drop) continue;
+         if (open != none && tags[open].line != tag.line) open = none;   // Unmatched on its line
+         if (tag.type == open_type && open == none) {
+            open = i;
+         } else if (tag.type == close_type && open != none) {
+            if (paired == Drop) {
+               // Everything from the opening tag through the closing tag is removed
+               for (size_t j = open + 1; j <= i; ++j) tags[j].action = Drop;
+               tags[open].end = tag.end;
+            }
+            tags[open].action = paired;
+            tag.action = paired;
+            open = none;
+         }
+      }
+   }
+
+   // Write the text with its markup stripped.  out may equal text -- output never runs ahead of input.
+   size_t Emit(const char* text,size_t length,const std::vector<Tag>& tags,char* out,bool blank_controls) {
+      size_t cursor(0),written(0);
+      auto copy = [&](size_t from,size_t to) {
+         if (blank_controls) {
+            for (size_t i = from; i < to; ++i) out[written++] = text[i] < ' ' ? ' ' : text[i];
+         } else {
+            if (out + written != text + from) memmove(out+written,text+from,to-from);
+            written += to - from;
+         }
+      };
+      for (size_t i = 0; i < tags.size(); ++i) {
+         const Tag& tag(tags[i]);
+         if (tag.begin < cursor) continue;                               // Inside a dropped <strike> range
+         copy(cursor,tag.begin);
+         if (tag.action == Keep)  copy(tag.begin,tag.end);
+         if (tag.action == Space) out[written++] = ' ';
+         cursor = tag.end;
+      }
+      copy(cursor,length);
+      return written;
+   }
+
+   void StripTags(const char* text,size_t length,std::vector<Tag>& tags) {
+      FindTags(text,length,tags);
+      PairTags(tags,EmOpen,EmClose,Space);
+      PairTags(tags,StrikeOpen,StrikeClose,Drop);
+      PairTags(tags,POpen,PClose,Space);
+   }
+}
+
+void HtmlStripper::Strip(std::string& text,bool blank_controls) {
+   std::vector<Tag> tags;
+   StripTags(text.data(),text.length(),tags);
+   if (text.empty()) return;
+   text.resize(Emit(text.data(),text.length(),tags,&text[0],blank_controls));
+}
+
+void HtmlStripper::Strip(boost::string_ref source,std::string& output,bool blank_controls) {
+   TagVector tags;
+   Strip(source,output,blank_controls,tags);
+}
+
+void HtmlStripper::Strip(boost::string_ref source,std::string& output,bool blank_controls,TagVector& tags) {
+   StripTags(source.data(),source.length(),tags);
+   output.resize(source.length());
+   if (source.empty()) return;
+   output.resize(Emit(source.data(),source.length(),tags,&output[0],blank_controls));
+}
+
+// Collect the text of the <em> spans that survive stripping, and of the <strike> spans stripping removes.
+// Each span is stripped of the markup inside it.  Spans within a removed <strike> span are part of that span.
+bool HtmlStripper::Amendments(boost::string_ref source,std::string& inserted,std::string& deleted) {
+   const char* const separator(" | ");
+   inserted.clear();
+   deleted.clear();
+   std::vector<Tag> tags;
+   StripTags(source.data(),source.length(),tags);
+   std::string span;
+   size_t cursor(0);
+   for (size_t i = 0; i < tags.size(); ++i) {
+      const Tag& tag(tags[i]);
+      if (tag.begin < cursor) continue;                                  // Inside a removed <strike> span
+      if (tag.type == StrikeOpen && tag.action == Drop) {
+         const size_t begin(tag.begin + strlen("<strike>")),end(tag.end - strlen("</strike>"));
+         Strip(source.substr(begin,end-begin),span,true);
+         deleted.append(span).append(separator);
+         cursor = tag.end;
+      } else if (tag.type == EmOpen && tag.action == Space) {
+         const auto close(std::find_if(tags.begin()+i+1,tags.end(),[](const Tag& t) { return t.type == EmClose && t.action == Space; }));
+         if (close == tags.end()) continue;
+         Strip(source.substr(tag.end,close->begin-tag.end),span,true);
+         inserted.append(span).append(separator);
+         cursor = close->end;
+      }
+   }
+   return !inserted.empty() || !deleted.empty();
+}
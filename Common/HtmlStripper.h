@@ -0,0 +1,45 @@
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief HtmlStripper removes the CAML and HTML markup from bill text in one pass.
+///        The result is the same as applying, in order,
+///           </?caml(.*?)>             removed
+///           <em>(.*?)</em>            replaced by " $1 "
+///           <strike>(.*?)</strike>    removed, content included
+///           <p>(.*?)</p>              replaced by " $1 "
+///           <span class=.EnSpace./>   removed
+///        with std::regex_replace.  As with std::regex, no match spans a line end.
+///        Markup is found by scanning each line for '<', then pairing the tags the way the chained
+///        replacements would.  Text is written once, into the source or into a reusable buffer.
+///        With blank_controls, characters below space (including bytes above 0x7f, char being signed) become spaces.
+//*****************************************************************************
+//
+
+namespace HtmlStripper {
+   enum TagType { Caml, EmOpen, EmClose, StrikeOpen, StrikeClose, POpen, PClose, EnSpace };
+   enum Action  { Keep, Drop, Space };
+
+   // A tag found in the text, and what stripping does with it
+   struct Tag {
+      TagType      type;
+      size_t       begin;
+      size_t       end;
+      unsigned int line;
+      Action       action;
+      Tag(TagType t, size_t b, size_t e, unsigned int l) : type(t), begin(b), end(e), line(l), action(t == Caml || t == EnSpace ? Drop : Keep) {}
+   };
+   typedef std::vector<Tag> TagVector;
+
+   void Strip(std::string& text, bool blank_controls);
+   void Strip(boost::string_ref source, std::string& output, bool blank_controls);
+   // As above, finding the tags in a caller's vector, so callers stripping many texts reuse its storage
+   void Strip(boost::string_ref source, std::string& output, bool blank_controls, TagVector& tags);
+   // The inserted (<em>) and deleted (<strike>) text of an amended bill, with control characters blanked.
+   // Spans are separated by " | ", so no phrase matches across two of them.  Answers false if there are none.
+   bool Amendments(boost::string_ref source, std::string& inserted, std::string& deleted);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstdio>
+#include <string>
+
+//
+//*****************************************************************************
+/// \brief MappedFile gives read-only access to a file's contents without copying them.
+///        Files of at least mapping_threshold bytes are memory mapped.  Smaller files, where setting up a mapping
+///        costs more than the read, are read into a buffer with a single fread.
+///        The contents are the file's bytes as stored -- line endings are not translated.
+///        A file that can't be opened has empty contents.
+//*****************************************************************************
+//
+
+class MappedFile : private boost::noncopyable {
+public:
+   static const size_t mapping_threshold = 16 * 1024;
+
+   explicit MappedFile(const std::string& path) : data(NULL), size(0), open(false) {
+      boost::system::error_code ec;
+      const boost::uintmax_t file_size(boost::filesystem::file_size(path,ec));
+      if (ec) return;
+      if (file_size >= mapping_threshold) {
+         try {
+            mapping.reset(new boost::interprocess::file_mapping(path.c_str(),boost::interprocess::read_only));
+            region.reset(new boost::interprocess::mapped_region(*mapping,boost::interprocess::read_only));
+            data = static_cast<const char*>(region->get_address());
+            size = region->get_size();
+            open = true;
+            return;
+         } catch (const boost::interprocess::interprocess_exception&) {
+            region.reset();                                            // Fall back to reading the file
+            mapping.reset();
+         }
+      }
+      FILE* file(std::fopen(path.c_str(),"rb"));
+      if (!file) return;
+      buffer.resize(static_cast<size_t>(file_size));
+      if (!buffer.empty()) buffer.resize(std::fread(&buffer[0],1,buffer.size(),file));
+      std::fclose(file);
+      data = buffer.data();
+      size = buffer.size();
+      open = true;
+   }
+
+   bool              IsOpen()   const { return open; }
+   const char*       Data()     const { return data; }
+   size_t            Size()     const { return size; }
+   boost::string_ref Contents() const { return boost::string_ref(data,size); }
+
+private:
+   boost::scoped_ptr<boost::interprocess::file_mapping>  mapping;
+   boost::scoped_ptr<boost::interprocess::mapped_region> region;
+   std::string                                           buffer;     // Contents of a file too small to map
+   const char*                                           data;
+   size_t                                                size;
+   bool                                                  open;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "db_capublic.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+#include <map>
+#include <string>
+
+//
+//*****************************************************************************
+/// \brief QueryPlanAudit finds the queries that read a whole table to find a few rows.
+///        While it exists, it records each statement run on the connection, with its literals replaced by ?, so that
+///        lookups differing only in the bill they name are counted as one.  Report asks SQLite how it would run each
+///        of them (EXPLAIN QUERY PLAN), and logs those that filter rows yet scan a table without an index.
+///        A diagnostic: recording costs a map lookup per statement run.
+//*****************************************************************************
+//
+
+class QueryPlanAudit : private boost::noncopyable {
+public:
+   explicit QueryPlanAudit(boost::weak_ptr<DB_capublic> database);
+   ~QueryPlanAudit();
+   size_t Report();                                   // Answers the number of queries that scan a table
+private:
+   static int Trace(unsigned type, void* audit, void* statement, void* sql);
+   void       Record(const char* sql);
+   boost::weak_ptr<DB_capublic>   db_public;
+   struct Recorded {
+      size_t      runs;
+      std::string example;                            // The text of one run, literals and all, to explain
+   };
+   boost::mutex                      mutex;           // Statements are run, and recorded, on several threads
+   std::map<std::string,Recorded>    statements;      // By text with literals replaced
+};
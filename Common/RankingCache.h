@@ -0,0 +1,36 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "db_capublic.h"
+
+#include <boost/weak_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// The ranking of one bill text under one set of ranking terms
+struct CachedRanking {
+   score_t                   neg_score;           // Under the scores of the run that cached it.  Rankers tally the counts again.
+   score_t                   pos_score;
+   std::vector<unsigned int> counts;              // Match count of each term, in the order of the term set
+   CachedRanking() : neg_score(0), pos_score(0) {}
+};
+
+//
+//*****************************************************************************
+/// \brief RankingCache stores rankings by content: the hash of a bill's stripped text and the hash of the term set
+///        it was ranked with.  Versions whose text is identical, or differs only in markup, share an entry, so
+///        each is counted once.  Entries of other term sets are pruned once a run under a new term set finishes.
+//*****************************************************************************
+//
+
+class RankingCache {
+public:
+   RankingCache(boost::weak_ptr<DB_capublic> database, bool import_leg_data);
+   ~RankingCache() {}
+   std::map<std::string,CachedRanking> Read (const std::string& term_set_hash);                  // Keyed by text hash
+   bool                                Write(const std::string& text_hash, const std::string& term_set_hash, const CachedRanking& ranking);
+   bool                                Prune(const std::string& term_set_hash);
+private:
+   boost::weak_ptr<DB_capublic> db_public;
+};
@@ -0,0 +1,138 @@
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "RankingTermFile.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/foreach.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+   const char           cache_magic[4] = { 'C', 'T', 'R', 'M' };
+   const boost::uint32_t cache_version(1);                  // Increment whenever the cache layout changes
+
+   std::string CachePath(const std::string& xml_path) { return xml_path + ".cache"; }
+
+   // Parse the <Pair> and <Phrase> elements of a RegexScore file.  An element lacking a Key, Regex or Score is skipped.
+   bool ParseXML(const std::string& xml_path,RankingTermFile& result) {
+      boost::property_tree::ptree pt;
+      try {
+         boost::property_tree::read_xml(xml_path,pt);
+      } catch (const boost::property_tree::xml_parser_error&) {
+         return false;                                          // As before, a missing or unreadable file has no terms
+      }
+      BOOST_FOREACH(const boost::property_tree::ptree::value_type& element,pt.get_child("Regex_Score",boost::property_tree::ptree())) {
+         const bool pair(element.first == "Pair");
+         if (!pair && element.first != "Phrase") continue;
+         const boost::optional<std::string> key  (element.second.get_optional<std::string>("Key"));
+         const boost::optional<std::string> regex(element.second.get_optional<std::string>("Regex"));
+         const boost::optional<std::string> score(element.second.get_optional<std::string>("Score"));
+         if (!key || !regex || !score) continue;
+         std::stringstream ss(score.get());
+         int int_score(0);
+         ss >> int_score;
+         (pair ? result.pairs : result.phrases).push_back(TermDefinition(key.get(),regex.get(),int_score));
+      }
+      return true;
+   }
+
+   // Cache layout: magic, version, XML hash, then the pairs and the phrases, each a count followed by key, regex and score
+   void WriteString(std::ostream& os,const std::string& s) {
+      const boost::uint32_t length(static_cast<boost::uint32_t>(s.length()));
+      os.write(reinterpret_cast<const char*>(&length),sizeof(length));
+      os.write(s.data(),s.length());
+   }
+
+   void WriteTerms(std::ostream& os,const std::vector<TermDefinition>& terms) {
+      const boost::uint32_t count(static_cast<boost::uint32_t>(terms.size()));
+      os.write(reinterpret_cast<const char*>(&count),sizeof(count));
+      std::for_each(terms.begin(),terms.end(),[&](const TermDefinition& term) {
+         const boost::int32_t score(term.score);
+         WriteString(os,term.key);
+         WriteString(os,term.regex);
+         os.write(reinterpret_cast<const char*>(&score),sizeof(score));
+      });
+   }
+
+   void WriteCache(const std::string& cache_path,unsigned long long xml_hash,const RankingTermFile& terms) {
+      const std::string temporary(cache_path + ".tmp");
+      {  std::ofstream os(temporary,std::ios::binary | std::ios::trunc);
+         if (!os) return;
+         const boost::uint64_t hash(xml_hash);
+         os.write(cache_magic,sizeof(cache_magic));
+         os.write(reinterpret_cast<const char*>(&cache_version),sizeof(cache_version));
+         os.write(reinterpret_cast<const char*>(&hash),sizeof(hash));
+         WriteTerms(os,terms.pairs);
+         WriteTerms(os,terms.phrases);
+         if (!os) return;
+      }
+      boost::system::error_code ec;
+      boost::filesystem::rename(temporary,cache_path,ec);     // Readers never see a partly written cache
+   }
+
+   // Reads the cache, checking every length against the bytes remaining
+   class CacheReader {
+   public:
+      explicit CacheReader(boost::string_ref contents) : data(contents), ok(true) {}
+      bool Ok() const { return ok; }
+      template <typename T> T Read() {
+         T value = T();
+         if (data.length() < sizeof(T)) { ok = false; return value; }
+         memcpy(&value,data.data(),sizeof(T));
+         data.remove_prefix(sizeof(T));
+         return value;
+      }
+      std::string ReadString() {
+         const boost::uint32_t length(Read<boost::uint32_t>());
+         if (!ok || data.length() < length) { ok = false; return std::string(); }
+         const std::string result(data.data(),length);
+         data.remove_prefix(length);
+         return result;
+      }
+      std::vector<TermDefinition> ReadTerms() {
+         std::vector<TermDefinition> result;
+         const boost::uint32_t count(Read<boost::uint32_t>());
+         for (boost::uint32_t i = 0; ok && i < count; ++i) {
+            const std::string key(ReadString());
+            const std::string regex(ReadString());
+            const boost::int32_t score(Read<boost::int32_t>());
+            if (ok) result.push_back(TermDefinition(key,regex,score));
+         }
+         return result;
+      }
+   private:
+      boost::string_ref data;
+      bool              ok;
+   };
+
+   bool ReadCache(const std::string& cache_path,unsigned long long xml_hash,RankingTermFile& terms) {
+      const MappedFile file(cache_path);
+      if (!file.IsOpen() || file.Size() < sizeof(cache_magic) || memcmp(file.Data(),cache_magic,sizeof(cache_magic)) != 0) return false;
+      CacheReader reader(file.Contents().substr(sizeof(cache_magic)));
+      if (reader.Read<boost::uint32_t>() != cache_version || reader.Read<boost::uint64_t>() != xml_hash) return false;
+      terms.pairs   = reader.ReadTerms();
+      terms.phrases = reader.ReadTerms();
+      return reader.Ok();
+   }
+}
+
+RankingTermFile RankingTermFiles::Load(const std::string& xml_path) {
+   RankingTermFile result;
+   unsigned long long xml_hash(0);
+   {  const MappedFile xml(xml_path);
+      xml_hash = ContentHash(xml.Contents());
+   }
+   const std::string cache_path(CachePath(xml_path));
+   if (!ReadCache(cache_path,xml_hash,result)) {
+      result = RankingTermFile();
+      if (ParseXML(xml_path,result)) WriteCache(cache_path,xml_hash,result);
+   }
+   return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "TermSet.h"
+
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief RankingTermFile holds the terms of a RegexScore XML file.
+///        Load parses the XML once with boost::property_tree and saves the terms in a binary cache beside it
+///        (the XML file name with ".cache" appended).  Later loads read the cache while the hash of the XML
+///        matches the hash recorded in the cache, and the cache format version is current.
+//*****************************************************************************
+//
+
+struct RankingTermFile {
+   std::vector<TermDefinition> pairs;                 // <Pair> terms, matched against single words
+   std::vector<TermDefinition> phrases;               // <Phrase> terms, matched against the text
+};
+
+namespace RankingTermFiles {
+   RankingTermFile Load(const std::string& xml_path);
+}
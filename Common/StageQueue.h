@@ -0,0 +1,90 @@
+#pragma once
+
+#include <boost/atomic.hpp>
+#include <boost/chrono/duration.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <sstream>
+#include <string>
+
+//
+//*****************************************************************************
+/// \brief StageQueue joins two stages of a pipeline with a bounded lock-free queue of item indexes.
+///        Push waits while the queue is full, and Pop waits while it is empty, yielding the processor and then
+///        sleeping briefly.  Once the producing stage closes the queue, Pop answers false when it is empty.
+///        A consuming stage that stops early closes the queue too, and Push then answers false, so the producer stops.
+///        Each wait counts as a stall of the waiting stage; with the queue's peak and mean depth, the stalls
+///        show which stage holds the pipeline back.
+//*****************************************************************************
+//
+
+class StageQueue : boost::noncopyable {
+public:
+   explicit StageQueue(size_t capacity)
+      : queue(capacity), capacity(capacity), closed(false), depth(0), peak(0), pushes(0), depth_total(0), full_stalls(0), empty_stalls(0) {}
+
+   // depth counts the item before it is pushed, so a consumer popping it at once cannot take depth below zero.
+   // Answers false, without pushing, once the queue is closed.
+   bool Push(size_t index) {
+      if (closed.load()) return false;
+      size_t now(++depth);
+      for (unsigned int attempt = 0; !queue.bounded_push(index); ++attempt) {
+         --depth;
+         if (closed.load()) return false;
+         if (attempt == 0) ++full_stalls;
+         Wait(attempt);
+         now = ++depth;
+      }
+      size_t highest(peak.load());
+      while (now > highest && !peak.compare_exchange_weak(highest,now)) {}
+      ++pushes;
+      depth_total += now;
+      return true;
+   }
+
+   // Answers false once the queue is closed and empty
+   bool Pop(size_t& index) {
+      for (unsigned int attempt = 0; ; ++attempt) {
+         if (queue.pop(index)) {
+            --depth;
+            if (attempt > 0) ++empty_stalls;
+            return true;
+         }
+         if (closed.load()) {
+            if (attempt > 0) ++empty_stalls;
+            if (!queue.pop(index)) return false;
+            --depth;
+            return true;
+         }
+         Wait(attempt);
+      }
+   }
+
+   void Close() { closed = true; }
+
+   // Depth and stall counters, for the log
+   std::string Report(const std::string& name) const {
+      std::stringstream ss;
+      ss << name << ": capacity " << capacity << ", peak depth " << peak.load()
+         << ", mean depth " << (pushes.load() > 0 ? static_cast<double>(depth_total.load()) / pushes.load() : 0.0)
+         << ", " << full_stalls.load() << " pushes stalled on a full queue, " << empty_stalls.load() << " pops stalled on an empty queue";
+      return ss.str();
+   }
+
+private:
+   static void Wait(unsigned int attempt) {
+      if (attempt < 64) boost::this_thread::yield();
+      else              boost::this_thread::sleep_for(boost::chrono::microseconds(200));
+   }
+
+   boost::lockfree::queue<size_t>      queue;
+   const size_t                        capacity;
+   boost::atomic<bool>                 closed;
+   boost::atomic<size_t>               depth;
+   boost::atomic<size_t>               peak;
+   boost::atomic<size_t>               pushes;
+   boost::atomic<unsigned long long>   depth_total;        // Sum of the depths after each push, for the mean
+   boost::atomic<size_t>               full_stalls;
+   boost::atomic<size_t>               empty_stalls;
+};
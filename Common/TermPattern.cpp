@@ -0,0 +1,75 @@
+#include "TermPattern.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define TERMPATTERN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <string>
+
+namespace {
+   // Folding sets bit 5, mapping upper case letters onto lower case.  Digits already have it set, and underscore
+   // becomes 0x7f, which is no other word character, so words fold without collisions.
+   const char fold_bit(0x20);
+
+   inline char Fold(char c) { return static_cast<char>(c | fold_bit); }
+
+   // Whether length characters of a word equal the folded literal, ignoring case
+   bool EqualFolded(const char* word,const char* folded,size_t length) {
+      size_t i(0);
+#if TERMPATTERN_SSE2
+      const __m128i fold(_mm_set1_epi8(fold_bit));
+      for ( ; i + 16 <= length; i += 16) {
+         const __m128i w(_mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(word+i)),fold));
+         const __m128i f(_mm_loadu_si128(reinterpret_cast<const __m128i*>(folded+i)));
+         if (_mm_movemask_epi8(_mm_cmpeq_epi8(w,f)) != 0xffff) return false;
+      }
+#endif
+      for ( ; i < length; ++i) {
+         if (Fold(word[i]) != folded[i]) return false;
+      }
+      return true;
+   }
+
+   bool IsLiteralCharacter(char c) { return Tokenizer::IsWordCharacter(c); }
+   bool IsQuantifier(char c) { return c == '?' || c == '*' || c == '+' || c == '{'; }
+}
+
+TermPattern::TermPattern(const std::string& pattern) : kind(Regex) {
+   size_t i(0);
+   bool begins(false),ends(false);
+   if      (pattern.compare(0,1,"^")   == 0) { begins = true; i = 1; }
+   else if (pattern.compare(0,2,"\\b") == 0) { begins = true; i = 2; }
+   std::string text;
+   for ( ; i < pattern.length() && IsLiteralCharacter(pattern[i]); ++i) {
+      if (i+1 < pattern.length() && IsQuantifier(pattern[i+1])) return;
+      text += static_cast<char>(::tolower(static_cast<unsigned char>(pattern[i])));
+   }
+   if (text.empty()) return;
+   // What may follow the literal.  \w* matches any rest of a word, so it constrains nothing.
+   const std::string rest(pattern.substr(i));
+   if      (rest == "$"     || rest == "\\b")     ends = true;
+   else if (rest == "\\w*$" || rest == "\\w*\\b") ends = false;
+   else if (rest != ""      && rest != "\\w*")    return;
+   kind = begins ? (ends ? Exact : Prefix) : (ends ? Suffix : Contains);
+   literal = text;
+   folded = text;
+   for (size_t c = 0; c < folded.length(); ++c) folded[c] = Fold(folded[c]);
+}
+
+bool TermPattern::Matches(const Token& word) const {
+   const size_t length(folded.length());
+   if (word.length() < length) return false;
+   switch (kind) {
+   case Exact:  return word.length() == length && EqualFolded(word.data(),folded.data(),length);
+   case Prefix: return EqualFolded(word.data(),folded.data(),length);
+   case Suffix: return EqualFolded(word.data() + word.length() - length,folded.data(),length);
+   case Contains:
+      for (size_t start = 0; start + length <= word.length(); ++start) {
+         if (Fold(word[start]) == folded[0] && EqualFolded(word.data() + start,folded.data(),length)) return true;
+      }
+      return false;
+   default:
+      return false;
+   }
+}
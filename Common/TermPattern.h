@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Tokenizer.h"
+
+#include <string>
+
+//
+//*****************************************************************************
+/// \brief TermPattern classifies a word term's <Regex> by how it can match a word, so most terms are matched
+///        without the regex engine.  Terms are searched for (std::regex_search) ignoring case, and a word is a run of
+///        word characters, so within a word
+///           abc    abc\w*    abc\w*$              the word contains abc                  Contains
+///           ^abc   \babc     ^abc\w*              the word begins with abc               Prefix
+///           abc$   abc\b                          the word ends with abc                 Suffix
+///           ^abc$  \babc\b   ^abc\b   \babc$      the word is abc                        Exact
+///        where abc is any run of word characters none of which is quantified.  Anything else is Regex, and must
+///        be matched with the term's regex.  Literals are compared 16 characters at a time with SSE2, folding case.
+//*****************************************************************************
+//
+
+class TermPattern {
+public:
+   enum Kind { Contains, Prefix, Suffix, Exact, Regex };
+
+   TermPattern() : kind(Regex) {}
+   explicit TermPattern(const std::string& pattern);
+   Kind               Classification() const { return kind;    }
+   const std::string& Literal()        const { return literal; }      // Lower case.  Empty for Regex.
+   // Whether a word matches the term.  Not to be called for Regex terms.
+   bool Matches(const Token& word) const;
+
+private:
+   Kind        kind;
+   std::string literal;
+   std::string folded;                                 // literal with every character folded as Matches folds the word's
+};
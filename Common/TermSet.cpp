@@ -0,0 +1,391 @@
+#include "TermSet.h"
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+
+namespace {
+   // Map a character onto the automaton alphabet.  Answers -1 for characters that can't appear in a word.
+   int Symbol(char c) {
+      if (c >= 'a' && c <= 'z') return c - 'a';
+      if (c >= 'A' && c <= 'Z') return c - 'A';
+      if (c >= '0' && c <= '9') return 26 + (c - '0');
+      if (c == '_') return 36;
+      return -1;
+   }
+
+   bool IsQuantifier(char c) { return c == '?' || c == '*' || c == '{'; }
+
+   // Lower case text into result, reusing its storage
+   void Lowercase(boost::string_ref text,std::string& result) {
+      result.assign(text.begin(),text.end());
+      std::transform(result.begin(),result.end(),result.begin(),[](char c) { return static_cast<char>(::tolower(static_cast<unsigned char>(c))); });
+   }
+
+   bool EqualIgnoringCase(boost::string_ref text,const std::string& lower) {
+      if (text.length() != lower.length()) return false;
+      for (size_t i = 0; i < lower.length(); ++i) {
+         if (::tolower(static_cast<unsigned char>(text[i])) != lower[i]) return false;
+      }
+      return true;
+   }
+
+   // Split a phrase regex into lower case words, if it is words separated by \s+ or single spaces.
+   // Answers false for anything else, which must be matched with the regex.
+   bool AnalyzePhrase(const std::string& pattern,std::vector<std::string>& words,std::vector<bool>& single_spaces) {
+      words.assign(1,std::string());
+      single_spaces.clear();
+      for (size_t i = 0; i < pattern.length(); ) {
+         if (Symbol(pattern[i]) >= 0) {
+            words.back() += static_cast<char>(::tolower(static_cast<unsigned char>(pattern[i])));
+            ++i;
+         } else if (words.back().length() > 0 && pattern.compare(i,3,"\\s+") == 0) {
+            words.push_back(std::string());
+            single_spaces.push_back(false);
+            i += 3;
+         } else if (words.back().length() > 0 && pattern[i] == ' ') {
+            words.push_back(std::string());
+            single_spaces.push_back(true);
+            ++i;
+         } else {
+            return false;
+         }
+      }
+      return words.size() > 1 && words.back().length() > 0;
+   }
+
+   // Extract the literal text that any word matching the regex must contain.
+   // Scanning stops at the first metacharacter, so the result is a (possibly empty) lower case prefix of the pattern.
+   // A character followed by an optional quantifier isn't required, so it is dropped.
+   void AnalyzePattern(const std::string& pattern, std::string& literal, bool& anchored) {
+      literal.clear();
+      anchored = false;
+      if (pattern.find('|') != std::string::npos) return;            // Alternation -- no single literal is required
+      size_t i(0);
+      if      (pattern.compare(0,1,"^")   == 0) { anchored = true; i = 1; }
+      else if (pattern.compare(0,2,"\\b") == 0) { anchored = true; i = 2; }     // Within a word, \b can only match at its start
+      for ( ; i < pattern.length(); ++i) {
+         const char c(pattern[i]);
+         if (Symbol(c) < 0) break;                                   // Metacharacter, escape, or a character no word contains
+         if (i+1 < pattern.length() && IsQuantifier(pattern[i+1])) break;
+         literal += static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+      }
+   }
+}
+
+// Add terms, replacing any earlier term of the profile with the same key and polarity.  Keys are shared by the words and phrases of a file.
+void TermSet::Add(const std::vector<TermDefinition>& definitions,Polarity polarity,unsigned int profile)        { AddTerms(definitions,polarity,profile,false); }
+void TermSet::AddPhrases(const std::vector<TermDefinition>& definitions,Polarity polarity,unsigned int profile) { AddTerms(definitions,polarity,profile,true);  }
+
+void TermSet::AddTerms(const std::vector<TermDefinition>& definitions,Polarity polarity,unsigned int profile,bool phrase) {
+   std::for_each(definitions.begin(),definitions.end(),[&](const TermDefinition& definition) {
+      Term term;
+      term.key      = definition.key;
+      term.pattern  = definition.regex;
+      term.rx       = std::regex(definition.regex,std::regex::icase);
+      term.score    = definition.score;
+      term.polarity = polarity;
+      term.profile  = profile;
+      term.phrase   = phrase;
+      if (phrase) {
+         term.anchored = false;
+         if (!AnalyzePhrase(definition.regex,term.phrase_words,term.single_spaces)) term.phrase_words.clear();
+      } else {
+         AnalyzePattern(definition.regex,term.literal,term.anchored);
+         term.matcher = TermPattern(definition.regex);
+      }
+      auto existing(std::find_if(terms.begin(),terms.end(),[&](const Term& t) { return t.key == term.key && t.polarity == polarity && t.profile == profile; }));
+      if (existing != terms.end()) *existing = term;
+      else terms.push_back(term);
+   });
+   compiled = false;
+}
+
+TermSet TermSet::Subset(const std::vector<unsigned int>& term_indexes) const {
+   TermSet result;
+   std::for_each(term_indexes.begin(),term_indexes.end(),[&](unsigned int term_index) { result.terms.push_back(terms[term_index]); });
+   result.Compile();
+   return result;
+}
+
+// Insert a term's literal into the trie
+void TermSet::AddLiteral(unsigned int term_index) {
+   const std::string& literal(terms[term_index].literal);
+   int state(0);
+   std::for_each(literal.begin(),literal.end(),[&](char c) {
+      const int symbol(Symbol(c));
+      if (transitions[state][symbol] < 0) {
+         transitions[state][symbol] = static_cast<int>(transitions.size());
+         Transitions empty;
+         empty.fill(-1);
+         transitions.push_back(empty);
+         outputs.push_back(std::vector<std::pair<unsigned int,unsigned int>>());
+      }
+      state = transitions[state][symbol];
+   });
+   outputs[state].push_back(std::make_pair(term_index,static_cast<unsigned int>(literal.length())));
+}
+
+// Build the automaton from the literals of all terms
+void TermSet::Compile() {
+   Transitions empty;
+   empty.fill(-1);
+   transitions.assign(1,empty);
+   outputs.assign(1,std::vector<std::pair<unsigned int,unsigned int>>());
+   unfiltered.clear();
+   phrase_starts.clear();
+   first_lengths.clear();
+   searched.clear();
+   for (unsigned int i = 0; i < terms.size(); ++i) {
+      if (terms[i].phrase) {
+         if (terms[i].phrase_words.empty()) {
+            searched.push_back(i);
+         } else {
+            phrase_starts[terms[i].phrase_words.front()].push_back(i);
+            first_lengths.insert(terms[i].phrase_words.front().length());
+         }
+      } else if (terms[i].literal.length() == 0) {
+         unfiltered.push_back(i);
+      } else {
+         AddLiteral(i);
+      }
+   }
+
+   // Breadth-first, point each state's failure at the longest proper suffix that is also a trie state,
+   // and resolve missing transitions so matching never has to follow failure links.
+   failures.assign(transitions.size(),0);
+   std::queue<int> pending;
+   for (int symbol = 0; symbol < alphabet_size; ++symbol) {
+      int& next(transitions[0][symbol]);
+      if (next < 0) next = 0;
+      else pending.push(next);
+   }
+   while (!pending.empty()) {
+      const int state(pending.front());
+      pending.pop();
+      const std::vector<std::pair<unsigned int,unsigned int>>& inherited(outputs[failures[state]]);
+      outputs[state].insert(outputs[state].end(),inherited.begin(),inherited.end());
+      for (int symbol = 0; symbol < alphabet_size; ++symbol) {
+         const int next(transitions[state][symbol]);
+         if (next < 0) {
+            transitions[state][symbol] = transitions[failures[state]][symbol];
+         } else {
+            failures[next] = transitions[failures[state]][symbol];
+            pending.push(next);
+         }
+      }
+   }
+
+   // The word terms of each profile and polarity are walked in the order of their lower case keys.  Keys differing
+   // only in case keep their key order, as they did in the legacy ranker's map.
+   std::map<std::pair<unsigned int,Polarity>,std::vector<unsigned int>> by_walk;
+   std::vector<std::string> lower_keys(terms.size());
+   for (unsigned int i = 0; i < terms.size(); ++i) {
+      if (terms[i].phrase) continue;
+      Lowercase(terms[i].key,lower_keys[i]);
+      by_walk[std::make_pair(terms[i].profile,terms[i].polarity)].push_back(i);
+   }
+   walks.clear();
+   std::for_each(by_walk.begin(),by_walk.end(),[&](const std::pair<const std::pair<unsigned int,Polarity>,std::vector<unsigned int>>& walk) {
+      walks.push_back(walk.second);
+      std::sort(walks.back().begin(),walks.back().end(),[&](unsigned int a,unsigned int b) {
+         const int order(lower_keys[a].compare(lower_keys[b]));
+         return order != 0 ? order < 0 : terms[a].key < terms[b].key;
+      });
+   });
+   compiled = true;
+}
+
+// Collect the terms that match a word.
+// stamps/stamp keep a term from being proposed twice for the same word.
+void TermSet::MatchWord(const Token& word,std::vector<unsigned int>& candidates,std::vector<unsigned int>& stamps,unsigned int stamp) const {
+   candidates.clear();
+   int state(0);
+   for (unsigned int i = 0; i < word.length(); ++i) {
+      const int symbol(Symbol(word[i]));
+      state = symbol < 0 ? 0 : transitions[state][symbol];
+      const std::vector<std::pair<unsigned int,unsigned int>>& found(outputs[state]);
+      std::for_each(found.begin(),found.end(),[&](const std::pair<unsigned int,unsigned int>& output) {
+         const unsigned int term_index(output.first);
+         if (stamps[term_index] != stamp && (!terms[term_index].anchored || i+1 == output.second)) {
+            stamps[term_index] = stamp;
+            candidates.push_back(term_index);
+         }
+      });
+   }
+   candidates.insert(candidates.end(),unfiltered.begin(),unfiltered.end());
+
+   // Confirm each candidate by comparing characters, or with its regex when it is a true regex
+   candidates.erase(std::remove_if(candidates.begin(),candidates.end(),[&](unsigned int term_index) {
+      const Term& term(terms[term_index]);
+      if (term.matcher.Classification() != TermPattern::Regex) return !term.matcher.Matches(word);
+      return !std::regex_search(word.begin(),word.end(),term.rx);
+   }),candidates.end());
+}
+
+void TermSet::Count(const TokenVector& words,std::vector<unsigned int>& counts) const {
+   counts.assign(terms.size(),0);
+   CountWords(words,counts);
+}
+
+void TermSet::CountText(boost::string_ref text,TokenVector& words,std::vector<unsigned int>& counts) const {
+   TermScratch scratch;
+   CountText(text,words,counts,scratch);
+}
+
+void TermSet::CountText(boost::string_ref text,TokenVector& words,std::vector<unsigned int>& counts,TermScratch& scratch) const {
+   counts.assign(terms.size(),0);
+   CountPhrases(text,words,counts,scratch);
+   std::sort(words.begin(),words.end());                    // Profiler shows the sort is not expensive -- less than 2%
+   CountWords(words,counts,scratch);
+}
+
+// A stamp no term of the scratch has been proposed with.  Stamps keep growing from text to text, so the stamps
+// needn't be cleared between texts; they are only reset when their size doesn't fit this set, or the stamp wraps.
+unsigned int TermSet::NextStamp(TermScratch& scratch) const {
+   if (scratch.stamps.size() != terms.size() || ++scratch.stamp == 0) {
+      scratch.stamps.assign(terms.size(),0);
+      scratch.stamp = 1;
+   }
+   return scratch.stamp;
+}
+
+void TermSet::CountWords(const TokenVector& words,std::vector<unsigned int>& counts) const {
+   TermScratch scratch;
+   CountWords(words,counts,scratch);
+}
+
+// Add the matches of word terms.  words must be sorted.
+void TermSet::CountWords(const TokenVector& words,std::vector<unsigned int>& counts,TermScratch& scratch) const {
+   if (!compiled) return;
+   scratch.runs.clear();
+   scratch.run_lengths.clear();
+   for (auto itr = words.cbegin(); itr != words.cend(); ) {
+      const auto run_end(std::find_if(itr,words.cend(),[&](const Token& w) { return w != *itr; }));
+      scratch.runs.push_back(*itr);
+      scratch.run_lengths.push_back(static_cast<unsigned int>(std::distance(itr,run_end)));
+      itr = run_end;
+   }
+   CountWordRuns(scratch.runs,scratch.run_lengths,counts,scratch);
+}
+
+// Each distinct word is matched once, noting the runs each term matches.  Then each walk finds, for each of its terms,
+// the first run the term matches at or past where the walk stands, and counts it and the runs following it that the
+// term also matches.  The walk resumes after the last of them.
+void TermSet::CountWordRuns(const TokenVector& runs,const std::vector<unsigned int>& run_lengths,std::vector<unsigned int>& counts,TermScratch& scratch) const {
+   if (!compiled) return;
+   std::vector<std::vector<unsigned int>>& matched(scratch.matched);
+   matched.resize(terms.size());
+   std::for_each(matched.begin(),matched.end(),[](std::vector<unsigned int>& term_runs) { term_runs.clear(); });
+   for (unsigned int r = 0; r < runs.size(); ++r) {
+      MatchWord(runs[r],scratch.candidates,scratch.stamps,NextStamp(scratch));
+      std::for_each(scratch.candidates.begin(),scratch.candidates.end(),[&](unsigned int term_index) { matched[term_index].push_back(r); });
+   }
+   std::for_each(walks.begin(),walks.end(),[&](const std::vector<unsigned int>& walk) {
+      unsigned int start(0);                                  // The first run not yet passed
+      std::for_each(walk.begin(),walk.end(),[&](unsigned int term_index) {
+         const std::vector<unsigned int>& term_runs(matched[term_index]);
+         auto itr(std::lower_bound(term_runs.begin(),term_runs.end(),start));
+         if (itr == term_runs.end()) return;
+         for (start = *itr; itr != term_runs.end() && *itr == start; ++itr, ++start) counts[term_index] += run_lengths[start];
+      });
+   });
+}
+
+// Whether a phrase matches starting in words[first].  The first word of the phrase must end words[first],
+// the last must begin the last word matched, and the words between must match whole words.
+bool TermSet::MatchPhrase(const Term& term,boost::string_ref text,const TokenVector& words,size_t first) const {
+   const size_t last(first + term.phrase_words.size() - 1);
+   if (last >= words.size()) return false;
+   for (size_t i = first + 1; i <= last; ++i) {
+      const size_t k(i - first);
+      const boost::string_ref separator(words[i-1].end(),words[i].begin() - words[i-1].end());
+      if (term.single_spaces[k-1]) {
+         if (separator != " ") return false;
+      } else if (std::find_if(separator.begin(),separator.end(),[](char c) { return !::isspace(static_cast<unsigned char>(c)); }) != separator.end()) {
+         return false;
+      }
+      const std::string& word(term.phrase_words[k]);
+      if (i < last) {
+         if (!EqualIgnoringCase(words[i],word)) return false;
+      } else if (words[i].length() < word.length() || !EqualIgnoringCase(words[i].substr(0,word.length()),word)) {
+         return false;
+      }
+   }
+   return true;
+}
+
+void TermSet::CountPhrases(boost::string_ref text,const TokenVector& words,std::vector<unsigned int>& counts) const {
+   TermScratch scratch;
+   CountPhrases(text,words,counts,scratch);
+}
+
+// Add the matches of phrase terms.  words must be in text order.
+void TermSet::CountPhrases(boost::string_ref text,const TokenVector& words,std::vector<unsigned int>& counts,TermScratch& scratch) const {
+   if (!compiled) return;
+   if (!phrase_starts.empty()) {
+      std::vector<const char*>& resume(scratch.resume);
+      resume.assign(terms.size(),text.begin());
+      for (size_t i = 0; i < words.size(); ++i) {
+         const Token& word(words[i]);
+         std::for_each(first_lengths.begin(),first_lengths.end(),[&](size_t length) {
+            if (word.length() < length) return;
+            Lowercase(word.substr(word.length() - length),scratch.lowered);
+            const auto found(phrase_starts.find(scratch.lowered));
+            if (found == phrase_starts.end()) return;
+            std::for_each(found->second.begin(),found->second.end(),[&](unsigned int term_index) {
+               const Term& term(terms[term_index]);
+               if (word.end() - length < resume[term_index] || !MatchPhrase(term,text,words,i)) return;
+               ++counts[term_index];
+               resume[term_index] = words[i + term.phrase_words.size() - 1].begin() + term.phrase_words.back().length();
+            });
+         });
+      }
+   }
+   std::for_each(searched.begin(),searched.end(),[&](unsigned int term_index) {
+      counts[term_index] += static_cast<unsigned int>(std::distance(std::cregex_iterator(text.begin(),text.end(),terms[term_index].rx),std::cregex_iterator()));
+   });
+}
+
+unsigned int TermSet::Profiles() const {
+   unsigned int result(0);
+   std::for_each(terms.begin(),terms.end(),[&](const Term& term) { result = std::max(result,term.profile + 1); });
+   return result;
+}
+
+TermSetScores TermSet::Tally(const std::vector<unsigned int>& counts,bool showDetails) const {
+   TermSetScores result;
+   for (unsigned int i = 0; i < terms.size() && i < counts.size(); ++i) {
+      if (counts[i] > 0 && terms[i].profile == 0) {
+         const unsigned int worth(counts[i] * terms[i].score);
+         unsigned int& score(terms[i].polarity == Positive ? result.pos_score : result.neg_score);
+         score += worth;
+         if (showDetails) {
+            std::cout << "   " << counts[i] << " instances of " << terms[i].key
+               << " (" << terms[i].score << ")"
+               << ", worth = " << worth
+               << ", score = " << score
+               << std::endl;
+         }
+      }
+   }
+   return result;
+}
+
+void TermSet::TallyProfiles(const std::vector<unsigned int>& counts,std::vector<TermSetScores>& scores) const {
+   scores.assign(Profiles(),TermSetScores());
+   for (unsigned int i = 0; i < terms.size() && i < counts.size(); ++i) {
+      if (counts[i] > 0) {
+         TermSetScores& profile(scores[terms[i].profile]);
+         (terms[i].polarity == Positive ? profile.pos_score : profile.neg_score) += counts[i] * terms[i].score;
+      }
+   }
+}
+
+TermSetScores TermSet::Score(const TokenVector& words,bool showDetails) const {
+   std::vector<unsigned int> counts;
+   Count(words,counts);
+   return Tally(counts,showDetails);
+}
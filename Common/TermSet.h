@@ -0,0 +1,132 @@
+#pragma once
+
+#include <CommonTypes.h>
+#include "TermPattern.h"
+#include "Tokenizer.h"
+
+#include <array>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief TermSet compiles every ranking term from the positive and negative RegexScore files into one matcher.
+///        An Aho-Corasick automaton built from the literal text each term's regex requires proposes candidate
+///        terms for a word.  Candidates whose regex is a literal, a prefix or a suffix (see TermPattern.h) are confirmed
+///        by comparing characters, and only the rest with the term's regex.  Each distinct word of a bill is matched once.
+///        Word terms are counted as the legacy ranker counted them: the terms of each profile and polarity are walked in
+///        the case-insensitive order of their keys over the sorted words.  Each term counts the run of words matching it
+///        that begins with its first match past the run the term before it counted; the walk then resumes after that run.
+///        Terms may belong to several ranking profiles.  Every profile is counted in the same pass; Tally scores profile 0,
+///        and TallyProfiles scores all of them from the same counts.
+///        Phrase terms are counted by one forward pass over the words in text order.  A phrase regex made of
+///        words separated by \s+ or a single space is matched word by word against the tokens; any other
+///        phrase regex is searched for in the text.  Either way matches don't overlap, as with repeated regex_search.
+//*****************************************************************************
+//
+
+// One <Pair> or <Phrase> from a RegexScore file
+struct TermDefinition {
+   std::string key;
+   std::string regex;
+   int         score;
+   TermDefinition(const std::string& k, const std::string& r, int s) : key(k), regex(r), score(s) {}
+};
+
+// Buffers a TermSet fills while counting, kept from one text to the next so counting doesn't allocate once they
+// have grown to fit.  Not shared between threads.
+struct TermScratch {
+   std::vector<unsigned int> candidates;              // Terms matching the current word
+   std::vector<unsigned int> stamps;                  // The word each term was last proposed for
+   unsigned int              stamp;
+   std::vector<const char*>  resume;                  // Where the next match of each phrase may begin
+   std::string               lowered;                 // The end of a word, lower cased, to find the phrases it may begin
+   TokenVector               runs;                    // The distinct words of a text, sorted
+   std::vector<unsigned int> run_lengths;             // The occurrences of each
+   std::vector<std::vector<unsigned int>> matched;    // The runs each word term matches, in word order
+   TermScratch() : stamp(0) {}
+};
+
+struct TermSetScores {
+   score_t neg_score;
+   score_t pos_score;
+   TermSetScores() : neg_score(0), pos_score(0) {}
+};
+
+class TermSet {
+public:
+   enum Polarity { Negative, Positive };
+
+   TermSet() : compiled(false) {}
+   void Add(const std::vector<TermDefinition>& definitions, Polarity polarity, unsigned int profile = 0);
+   void AddPhrases(const std::vector<TermDefinition>& definitions, Polarity polarity, unsigned int profile = 0);
+   void Compile();
+   size_t Size() const { return terms.size(); }
+   const std::string& Key    (unsigned int term_index) const { return terms[term_index].key;      }
+   const std::string& Pattern(unsigned int term_index) const { return terms[term_index].pattern;  }
+   Polarity TermPolarity     (unsigned int term_index) const { return terms[term_index].polarity; }
+   bool IsPhrase             (unsigned int term_index) const { return terms[term_index].phrase;   }
+   int Weight                (unsigned int term_index) const { return terms[term_index].score;    }
+   unsigned int Profile      (unsigned int term_index) const { return terms[term_index].profile;  }
+   unsigned int Profiles() const;                     // One more than the highest profile of any term
+   // A compiled set of some of these terms.  Term i of the subset is term term_indexes[i] of this set.
+   TermSet Subset(const std::vector<unsigned int>& term_indexes) const;
+
+   // Count, for each term, the words matching it.  words must be sorted so that duplicates are adjacent.
+   void Count(const TokenVector& words, std::vector<unsigned int>& counts) const;
+   // Count every term, phrases included, in a text.  words are the text's words in text order; they are left sorted.
+   void CountText(boost::string_ref text, TokenVector& words, std::vector<unsigned int>& counts) const;
+   void CountText(boost::string_ref text, TokenVector& words, std::vector<unsigned int>& counts, TermScratch& scratch) const;
+   // The two steps of CountText, for callers that time them separately.  Both add to counts, which must hold a count per term.
+   void CountPhrases(boost::string_ref text, const TokenVector& words, std::vector<unsigned int>& counts) const;
+   void CountPhrases(boost::string_ref text, const TokenVector& words, std::vector<unsigned int>& counts, TermScratch& scratch) const;
+   void CountWords(const TokenVector& words, std::vector<unsigned int>& counts) const;
+   void CountWords(const TokenVector& words, std::vector<unsigned int>& counts, TermScratch& scratch) const;
+   // Count word terms from the distinct words of a text, sorted, and the occurrences of each, for callers that don't have the text
+   void CountWordRuns(const TokenVector& runs, const std::vector<unsigned int>& run_lengths, std::vector<unsigned int>& counts, TermScratch& scratch) const;
+   // Convert per-term counts into positive and negative scores of profile 0
+   TermSetScores Tally(const std::vector<unsigned int>& counts, bool showDetails) const;
+   // Convert per-term counts into the positive and negative scores of every profile, indexed by profile
+   void TallyProfiles(const std::vector<unsigned int>& counts, std::vector<TermSetScores>& scores) const;
+   TermSetScores Score(const TokenVector& words, bool showDetails) const;
+
+private:
+   static const int alphabet_size = 37;               // a-z, 0-9 and underscore -- the characters of a word
+   typedef std::array<int,alphabet_size> Transitions;
+
+   struct Term {
+      std::string key;
+      std::string pattern;                            // The regex as written in the RegexScore file
+      std::regex  rx;
+      TermPattern matcher;                            // How a word term is confirmed without its regex
+      int         score;
+      Polarity    polarity;
+      unsigned int profile;
+      std::string literal;                            // Lower case text the regex requires, empty if none could be found
+      bool        anchored;                           // Literal must begin the word
+      bool        phrase;
+      std::vector<std::string> phrase_words;          // Lower case words of a phrase, empty if it must be searched for
+      std::vector<bool>        single_spaces;         // Whether the words are separated by exactly one space, rather than \s+
+   };
+
+   void AddTerms(const std::vector<TermDefinition>& definitions, Polarity polarity, unsigned int profile, bool phrase);
+   void AddLiteral(unsigned int term_index);
+   void MatchWord(const Token& word, std::vector<unsigned int>& candidates, std::vector<unsigned int>& stamps, unsigned int stamp) const;
+   unsigned int NextStamp(TermScratch& scratch) const;
+   bool MatchPhrase(const Term& term, boost::string_ref text, const TokenVector& words, size_t first) const;
+
+   std::vector<Term>                                                   terms;
+   std::vector<unsigned int>                                           unfiltered;    // Terms without a literal, always candidates
+   std::vector<Transitions>                                            transitions;   // Automaton goto function, failures resolved
+   std::vector<int>                                                    failures;
+   std::vector<std::vector<std::pair<unsigned int,unsigned int>>>      outputs;       // (term index, literal length) ending at each state
+   std::map<std::string,std::vector<unsigned int>>                     phrase_starts; // Phrase terms by their lower case first word
+   std::set<size_t>                                                    first_lengths; // Lengths of the first words of phrases
+   std::vector<unsigned int>                                           searched;      // Phrase terms searched for with their regex
+   std::vector<std::vector<unsigned int>>                              walks;         // Word terms of each profile and polarity, in the order they are walked
+   bool                                                                compiled;
+};
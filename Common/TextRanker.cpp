@@ -0,0 +1,42 @@
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include "TextRanker.h"
+
+#include "BillText.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+void TextRanker::RankLob(boost::string_ref lob_contents,RankingScratch& scratch,ScoreBreakdown& result) const {
+   BillText::StripBillText(lob_contents,scratch.text,scratch.tags);
+   RankText(scratch.text,scratch,result);
+}
+
+void TextRanker::RankText(boost::string_ref text,RankingScratch& scratch,ScoreBreakdown& result) const {
+   Tokenizer::Tokenize(text.data(),text.length(),scratch.words);
+   result.words = scratch.words.size();
+   terms->CountText(text,scratch.words,result.counts,scratch.terms);
+   Tally(result.counts,result);
+}
+
+void TextRanker::Tally(const std::vector<unsigned int>& counts,ScoreBreakdown& result) const {
+   if (&result.counts != &counts) result.counts = counts;
+   terms->TallyProfiles(counts,result.profiles);
+   result.scores = result.profiles.empty() ? TermSetScores() : result.profiles[0];
+}
+
+// Threads take the next unranked text until none are left.  Each thread has its own scratch; the texts are only read.
+void TextRanker::RankLobs(const std::vector<boost::string_ref>& lob_contents,std::vector<ScoreBreakdown>& results,unsigned int threads) const {
+   results.assign(lob_contents.size(),ScoreBreakdown());
+   boost::atomic<size_t> next(0);
+   auto rank = [&]() {
+      RankingScratch scratch;
+      for (size_t i = next++; i < lob_contents.size(); i = next++) RankLob(lob_contents[i],scratch,results[i]);
+   };
+   const unsigned int helpers(std::min<unsigned int>(std::max(1u,threads),static_cast<unsigned int>(std::max<size_t>(1,lob_contents.size()))) - 1);
+   boost::thread_group group;
+   for (unsigned int t = 0; t < helpers; ++t) group.create_thread(rank);
+   rank();
+   group.join_all();
+}
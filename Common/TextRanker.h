@@ -0,0 +1,59 @@
+#pragma once
+
+#include "HtmlStripper.h"
+#include "TermSet.h"
+#include "Tokenizer.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief TextRanker ranks bill texts against a compiled term set that no caller can change.  It holds no other state,
+///        so one TextRanker may rank on any number of threads at once, and may live as long as the process does.
+///        Each concurrent call needs its own RankingScratch, which keeps the buffers one ranking fills so the next
+///        call on the same thread reuses them.  Results are returned as a ScoreBreakdown; nothing is accumulated globally.
+///        Phrases are counted within the caller's scratch too, not on the term pool BillRankerUtilities shares between
+///        threads, so concurrent calls never wait on one another.
+///        Once the scratch and the breakdown have grown to fit the largest bill, ranking a bill allocates nothing,
+///        except within std::regex for the terms that can only be matched with their regex.
+//*****************************************************************************
+//
+
+// Buffers reused from one ranking to the next: reset for each bill, never freed.  Not shared between threads.
+struct RankingScratch {
+   std::string               text;                    // Stripped text of the bill ranked last
+   HtmlStripper::TagVector   tags;                    // Markup found in its lob file
+   TokenVector               words;                   // Refer into text
+   TermScratch               terms;                   // Matching state of the term set
+   std::vector<unsigned int> counts;                  // Counts of a subset of the terms, for callers counting only some
+};
+
+// A ranked text's scores, and the counts they were tallied from
+struct ScoreBreakdown {
+   TermSetScores              scores;                 // Scores of profile 0
+   std::vector<TermSetScores> profiles;               // Scores of every profile, indexed by profile
+   std::vector<unsigned int>  counts;                 // Match count of each term, indexed like the term set
+   size_t                     words;                  // Words in the stripped text
+   ScoreBreakdown() : words(0) {}
+};
+
+class TextRanker {
+public:
+   explicit TextRanker(boost::shared_ptr<const TermSet> term_set) : terms(term_set) {}
+   const TermSet& Terms() const { return *terms; }
+
+   // Rank the contents of a lob file: the standard prefix and the HTML are removed first
+   void RankLob (boost::string_ref lob_contents, RankingScratch& scratch, ScoreBreakdown& result) const;
+   // Rank text already stripped of HTML
+   void RankText(boost::string_ref text, RankingScratch& scratch, ScoreBreakdown& result) const;
+   // Score counts found some other way, such as stored or cached counts
+   void Tally(const std::vector<unsigned int>& counts, ScoreBreakdown& result) const;
+   // Rank many lob files' contents at once on up to threads threads.  results[i] is the ranking of lob_contents[i].
+   void RankLobs(const std::vector<boost::string_ref>& lob_contents, std::vector<ScoreBreakdown>& results, unsigned int threads) const;
+
+private:
+   boost::shared_ptr<const TermSet> terms;
+};
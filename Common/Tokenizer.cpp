@@ -0,0 +1,76 @@
+#include "Tokenizer.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define TOKENIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <string>
+#include <vector>
+
+namespace {
+   // Character classes, indexed by unsigned char.  1 marks a word character.
+   struct CharacterClasses {
+      unsigned char is_word[256];
+      CharacterClasses() {
+         for (int c = 0; c < 256; ++c) {
+            is_word[c] = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+         }
+      }
+   };
+   const CharacterClasses classes;
+
+   bool IsWord(char c) { return classes.is_word[static_cast<unsigned char>(c)] != 0; }
+
+#if TOKENIZER_SSE2
+   // Bit i is set when byte i of the 16-byte block is a word character
+   inline unsigned int WordMask(const char* block) {
+      const __m128i bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)));
+      const __m128i folded(_mm_or_si128(bytes,_mm_set1_epi8(0x20)));          // Fold upper case onto lower case
+      // Signed compares -- bytes above 0x7f are negative, so they fall outside every range
+      const __m128i digit (_mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0'-1)),_mm_cmplt_epi8(bytes, _mm_set1_epi8('9'+1))));
+      const __m128i letter(_mm_and_si128(_mm_cmpgt_epi8(folded,_mm_set1_epi8('a'-1)),_mm_cmplt_epi8(folded,_mm_set1_epi8('z'+1))));
+      const __m128i under (_mm_cmpeq_epi8(bytes,_mm_set1_epi8('_')));
+      return static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digit,letter),under)));
+   }
+
+   inline unsigned int LowestSetBit(unsigned int mask) {
+      unsigned int index(0);
+      while ((mask & 1) == 0) { mask >>= 1; ++index; }
+      return index;
+   }
+#endif
+
+   // Answer the offset of the first character at or after pos that is (want_word) or isn't (!want_word) a word character
+   size_t Scan(const char* text,size_t pos,size_t length,bool want_word) {
+#if TOKENIZER_SSE2
+      while (pos + 16 <= length) {
+         const unsigned int mask(want_word ? WordMask(text+pos) : ~WordMask(text+pos) & 0xffff);
+         if (mask != 0) return pos + LowestSetBit(mask);
+         pos += 16;
+      }
+#endif
+      while (pos < length && IsWord(text[pos]) != want_word) ++pos;
+      return pos;
+   }
+}
+
+bool Tokenizer::IsWordCharacter(char c) { return IsWord(c); }
+
+// Fill a vector with the words in the text
+void Tokenizer::Tokenize(const char* text,size_t length,TokenVector& tokens) {
+   tokens.clear();
+   tokens.reserve(length / 6);                        // Rough words per character of bill text
+   size_t pos(0);
+   while (pos < length) {
+      const size_t start(Scan(text,pos,length,true));
+      if (start == length) break;
+      const size_t end(Scan(text,start,length,false));
+      tokens.push_back(Token(text+start,end-start));
+      pos = end;
+   }
+}
+
+void Tokenizer::Tokenize(const std::string& source,TokenVector& tokens) {
+   Tokenize(source.data(),source.length(),tokens);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <string>
+#include <vector>
+
+//
+//*****************************************************************************
+/// \brief Tokenizer splits bill text into words without copying it.
+///        A word is a run of the characters std::regex treats as \w -- letters, digits and underscore --
+///        so the result matches splitting on "[^\w]+".  Each token refers into the source text,
+///        which must outlive the tokens.
+//*****************************************************************************
+//
+
+typedef boost::string_ref   Token;
+typedef std::vector<Token>  TokenVector;
+
+namespace Tokenizer {
+   bool IsWordCharacter(char c);
+   void Tokenize(const char* text, size_t length, TokenVector& tokens);
+   void Tokenize(const std::string& source, TokenVector& tokens);
+}
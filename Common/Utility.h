@@ -1,9 +1,12 @@
 #pragma once
 #include <CommonTypes.h>
+#include "HtmlStripper.h"
+#include "MappedFile.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/path.hpp>
 #include <stdio.h>
+#include <string.h>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -15,18 +18,24 @@ namespace fs = boost::filesystem;
 
 namespace {
    std::string ReadFile(const std::string& fileName) {
-      std::ifstream ifs(fileName);
-      std::stringstream ss;
-      ss << ifs.rdbuf();
-      return ss.str();
+      const MappedFile file(fileName);
+      return std::string(file.Data(),file.Size());
    }
 
+   // Split a file into lines as std::getline would, dropping the carriage return of CR LF line endings
    std::vector<std::string> ReadFileLineByLine(const std::string& fileName) {
       std::vector<std::string> result;
-      std::ifstream ifs(fileName);
-      std::string line;
-      while (std::getline(ifs,line)) { result.push_back(line); }
-	  ifs.close();
+      const MappedFile file(fileName);
+      const char* pos(file.Data());
+      const char* const end(pos + file.Size());
+      while (pos < end) {
+         const char* eol(static_cast<const char*>(memchr(pos,'\n',end - pos)));
+         const char* next(eol ? eol + 1 : end);
+         if (!eol) eol = end;
+         if (eol > pos && *(eol-1) == '\r') --eol;
+         result.push_back(std::string(pos,eol));
+         pos = next;
+      }
       return result;
    }
 
@@ -127,12 +136,7 @@ namespace {
    // Remove HTML from a string
    std::string UtilityRemoveHTML(std::string& input) {
       // Remove HTML
-      std::string s1(std::regex_replace(input,std::regex("</?caml(.*?)>"),       std::string()));
-      std::string s2(std::regex_replace(s1,std::regex("<em>(.*?)</em>"),         std::string(" $1 ")));
-      std::string s3(std::regex_replace(s2,std::regex("<strike>(.*?)</strike>"), std::string()));
-      std::string s4(std::regex_replace(s3,std::regex("<p>(.*?)</p>"),           std::string(" $1 ")));
-      std::string s5(std::regex_replace(s4,std::regex("<span class=.EnSpace./>"),std::string()));        // std::string() instead of ""
-      input = s5;
+      if (input.find('<') != std::string::npos) HtmlStripper::Strip(input,false);
 
       //Translate from UTF-8
       UtilityTranslateFromUTF8(input);
@@ -7,6 +7,7 @@
 #include "Configuration.h"
 
 #include <string>
+#include <vector>
 
 #include <boost/foreach.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -23,6 +24,7 @@ namespace {
    std::string biennium;
    std::string bills_folder;
    std::string results_folder;
+   std::vector<RankingProfile> profiles;
 }
 
 struct bad_pointer : std::exception { 
@@ -54,6 +56,15 @@ Configuration::Configuration(const std::string& path) {
    biennium       = read_value(pt, "Circus.biennium");
    bills_folder   = read_value(pt, "Circus.local_data.bills_folder");
    results_folder = read_value(pt, "Circus.local_data.results_folder");
+   // Each <profile> under <keyword_files> names its own negative and positive files
+   profiles.clear();
+   boost::optional<boost::property_tree::ptree&> keyword_files(pt.get_child_optional("Circus.keyword_files"));
+   if (keyword_files) {
+      BOOST_FOREACH(const boost::property_tree::ptree::value_type& v, keyword_files.get()) {
+         if (v.first != "profile") continue;
+         profiles.push_back(RankingProfile(read_value(v.second, "name"), read_value(v.second, "negative"), read_value(v.second, "positive")));
+      }
+   }
 }
 
 
@@ -63,6 +74,7 @@ const std::string Configuration::Password()      { return password.c_str();
 const std::string Configuration::Site()          { return site.c_str();           }
 const std::string Configuration::Negative()      { return negative.c_str();       } 
 const std::string Configuration::Positive()      { return positive.c_str();       }
+const std::vector<RankingProfile> Configuration::Profiles() { return profiles;    }
 const std::string Configuration::Biennium()      { return biennium.c_str();       }
 const std::string Configuration::BillsFolder()   { return bills_folder.c_str();   }
 const std::string Configuration::ResultsFolder() { return results_folder.c_str(); }
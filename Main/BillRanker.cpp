@@ -1,243 +1,563 @@
+// Boost.Thread comes first: the Q and QC macros reached through CAPublic.h collide with boost::ratio
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include "StageQueue.h"
+
 #include "BillRanker.h"
 #include "BillRow.h"
+#include "BillText.h"
+#include "ContentHash.h"
 #include "Logger.h"
+#include "RankingTermFile.h"
 #include "ScopedElapsedTime.h"
+#include "TermSet.h"
+#include "TextRanker.h"
+#include "Tokenizer.h"
 #include "Utility.h"
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
 
 namespace {
-   typedef std::map<std::string,std::pair<std::regex,int>> RankWordMap;
-   typedef std::map<std::string,std::pair<std::regex,int>> RankPhraseMap;
-   typedef RankWordMap::iterator RankWordItr;
-   typedef RankWordMap::const_iterator RankWordCItr;
-   typedef std::vector<std::string> WordVector;
-   typedef std::vector<std::string>::const_iterator WordItr;
-   RankWordMap neg_wordMap,pos_wordMap;
-   RankWordMap neg_phraseMap,pos_phraseMap;
-
-   // Convert a string to lower case.
-   std::string ToLowerCase(const std::string& source) {
-      std::string result(source);
-      std::transform(result.begin(),result.end(),result.begin(),::tolower);
+   boost::scoped_ptr<const TextRanker> ranker;                       // Positive and negative word and phrase terms of every profile, compiled together
+   std::vector<std::string> profile_names;                           // Name of each profile, indexed like TermSet::Profile.  Profile 0 is unnamed.
+
+   // A profile's terms, their keys qualified by the profile's name so they don't collide with another profile's stored counts
+   std::vector<TermDefinition> InProfile(const std::vector<TermDefinition>& definitions,unsigned int profile) {
+      std::vector<TermDefinition> result(definitions);
+      if (profile > 0) std::for_each(result.begin(),result.end(),[&](TermDefinition& definition) { definition.key = profile_names[profile] + '/' + definition.key; });
       return result;
    }
 
-   std::string ExtractTerm(const std::string& matchElement,const std::string& regexString) {
-      const std::regex rx(regexString);
-      const std::string fmt("$1");
-      return std::regex_replace(matchElement,rx,fmt);
+   // Hash of a term's key and regex, and whether it is a phrase.  FNV-1a, so the hash doesn't change from build to build.
+   std::string PatternHash(const std::string& key,const std::string& pattern,bool phrase) {
+      return ContentHashText(ContentHash(key + '\0' + pattern + (phrase ? std::string("\0phrase",7) : std::string())));
    }
 
-   std::string SingleLine(std::string& source) {
-      std::for_each(source.begin(),source.end(),[](char& c) { if (c <= ' ') c = ' '; }); // Multiline not supported by std::regex
-      return source;
-   }
-   std::vector<std::string> ExtractRawTerms(const std::string& fileName,const std::regex& rx) {
+   // Hash of what each term's counts depend on, stored with the terms to find those changed since the last run.  A phrase's
+   // counts depend on its own key and regex.  A word term's depend on where the walk over the sorted words stands when it is
+   // reached (see TermSet.h), so on the keys and regexes of every word term of its profile and polarity.
+   std::vector<std::string> TermHashes() {
+      const TermSet& word_terms(ranker->Terms());
+      typedef std::pair<unsigned int,TermSet::Polarity> Walk;
+      std::map<Walk,std::vector<std::string>> walk_terms;
+      for (unsigned int i = 0; i < word_terms.Size(); ++i) {
+         if (!word_terms.IsPhrase(i)) walk_terms[Walk(word_terms.Profile(i),word_terms.TermPolarity(i))].push_back(word_terms.Key(i) + '\0' + word_terms.Pattern(i));
+      }
+      std::map<Walk,std::string> walk_hashes;
+      std::for_each(walk_terms.begin(),walk_terms.end(),[&](std::pair<const Walk,std::vector<std::string>>& walk) {
+         std::sort(walk.second.begin(),walk.second.end());
+         unsigned long long hash(ContentHash(boost::string_ref()));
+         std::for_each(walk.second.begin(),walk.second.end(),[&](const std::string& term) { hash = ContentHash(term + '\0',hash); });
+         walk_hashes[walk.first] = ContentHashText(hash);
+      });
       std::vector<std::string> result;
-      std::string source(SingleLine(ReadFile(fileName)));            // Read the file into a string
-      std::smatch matches;
-      while (std::regex_search(source,matches,rx)) {
-         const std::string member(matches[0]);                       // Current match
-         result.push_back(member);
-         source = matches.suffix().str();                            // Prepare for the next substring match
+      for (unsigned int i = 0; i < word_terms.Size(); ++i) {
+         const std::string pattern(word_terms.IsPhrase(i) ? word_terms.Pattern(i) : word_terms.Pattern(i) + '\0' + walk_hashes[Walk(word_terms.Profile(i),word_terms.TermPolarity(i))]);
+         result.push_back(PatternHash(word_terms.Key(i),pattern,word_terms.IsPhrase(i)));
       }
       return result;
    }
 
-   RankWordMap ExtractRankingTerms(const std::vector<std::string>& rawTerms,const std::regex& rx) {
-      RankWordMap result;
-      std::for_each(rawTerms.begin(),rawTerms.end(),[&](std::string source) {
-         std::smatch matches;
-         std::string keyMember,regexMember;                         // Save Key and Regex tuple members here
-         while (std::regex_search(source,matches,rx)) {
-            const std::string member(matches[0]);                    // Cycles through Key, Regex, and Score
-            // This is a Key definition, save the string
-            if (member.find("Key") != std::string::npos) {
-               keyMember = ExtractTerm(member,"<Key>(.*?)</Key>");
-               // This is a Regex definition, save the string
-            } else if (member.find("Regex") != std::string::npos) {
-               regexMember = ExtractTerm(member,"<Regex>(.*?)</Regex>");
-               // This is a Score definition, have all three members, build the map entry
-            } else {
-               const std::string score = ExtractTerm(member,"<Score>(.*?)</Score>");
-               std::stringstream ss2;
-               ss2 << score;
-               int intScore;
-               ss2 >> intScore;
-               const std::regex rx(regexMember,std::regex::icase);
-               result[keyMember] = std::make_pair(rx,intScore);
-            }
-            // Prepare for the next substring match
-            source = matches.suffix().str();
-         }
-      });
-      return result;
+   // How the term counts stored by earlier runs are reused
+   struct RescorePlan {
+      std::vector<std::string>                          hashes;           // Of each term, see TermHashes
+      std::vector<unsigned int>                         changed;          // Terms whose counts may differ from those of the last run
+      TermSet                                           changed_terms;    // The changed terms, compiled on their own
+      std::map<bill_ver_id_t,std::vector<unsigned int>> stored;           // Counts of counted versions, indexed like the ranker's terms
+   };
+   RescorePlan plan;
+
+   // Rankings of bill texts already counted under the current terms, by the hash of the stripped text
+   std::string                         term_set_hash;
+   std::map<std::string,CachedRanking> cached_rankings;
+
+   // Amendment-delta mode: an amended version is counted from the text its amendments insert and delete,
+   // relative to the stored counts of the version it amends
+   bool                                   rank_from_amendments(false);
+   std::map<bill_ver_id_t,bill_ver_id_t>  previous_versions;         // The version each version amends
+
+   // The cheapest way to find a bill's term counts
+   enum RankPath { Rescored, PartlyCounted, Cached, Amended, Counted, RankPaths };
+
+   // A ranked bill's counts for every term, and the terms counted from its text
+   struct RankedCounts {
+      ScoreBreakdown            breakdown;                            // Counts of every term, and the scores tallied from them
+      std::vector<unsigned int> computed;
+      RankPath                  path;
+      std::string               text_hash;                            // Hash of the stripped text, empty if it wasn't read
+      AmendmentDelta            delta;                                // Score change due to amendments, if Amended
+      RankedCounts() : path(Counted) {}
+   };
+
+   // Hash of every term's key, regex, polarity and whether it is a phrase, in the order of the ranker's terms.  Cached counts
+   // are in that order.  Scores aren't included, as in PatternHash: counts don't depend on them, and are tallied again each run.
+   std::string TermSetHash() {
+      const TermSet& word_terms(ranker->Terms());
+      unsigned long long hash(ContentHash(boost::string_ref()));
+      for (unsigned int i = 0; i < word_terms.Size(); ++i) {
+         std::stringstream ss;
+         ss << word_terms.Key(i) << '\0' << word_terms.Pattern(i) << '\0' << word_terms.IsPhrase(i) << '\0' << word_terms.TermPolarity(i) << '\0';
+         hash = ContentHash(ss.str(),hash);
+      }
+      return ContentHashText(hash);
    }
 
-   // Fill a vector with the search terms (sorted) contained in rankingTerms.
-   void AlphabetizedListOfRankingTerms(const RankWordMap rankingTerms,WordVector& rankingStrings) {
-      rankingStrings.clear();
-      rankingStrings.reserve(rankingTerms.size());
-      std::for_each(rankingTerms.begin(),rankingTerms.end(),[&](const std::pair<std::string,std::pair<std::regex,int>>& item) {
-         rankingStrings.push_back(item.first);
+   // Compare the ranking terms with those of the last run, and load the stored counts still usable.
+   // A score change alone leaves a term's counts valid.  Any other change to a word term changes the counts of every
+   // word term of its profile and polarity, so they are counted again together.
+   RescorePlan PlanRescoring(CAPublic& db) {
+      const TermSet& word_terms(ranker->Terms());
+      RescorePlan result;
+      result.hashes = TermHashes();
+      typedef std::pair<int,std::string> TermId;
+      std::map<TermId,std::string> previous;
+      const std::vector<RankingTermRecord> stored_terms(db.StoredRankingTerms());
+      std::for_each(stored_terms.begin(),stored_terms.end(),[&](const RankingTermRecord& term) {
+         previous[TermId(term.polarity,term.term_key)] = term.hash;
       });
-      std::sort(rankingStrings.begin(),rankingStrings.end(),[&](const std::string& a,const std::string& b) -> bool {
-         const std::string a_lower_case(ToLowerCase(a));
-         const std::string b_lower_case(ToLowerCase(b));
-         return a_lower_case.compare(b_lower_case) < 0;
+      std::map<TermId,unsigned int> current;
+      for (unsigned int i = 0; i < word_terms.Size(); ++i) {
+         const TermId id(word_terms.TermPolarity(i),word_terms.Key(i));
+         current[id] = i;
+         const auto found(previous.find(id));
+         if (found == previous.end() || found->second != result.hashes[i]) result.changed.push_back(i);
+      }
+      result.changed_terms = word_terms.Subset(result.changed);
+
+      const std::vector<bill_ver_id_t> counted(db.CountedBillVersions());
+      const std::map<bill_ver_id_t,std::vector<TermCount>> stored(db.ReadTermCounts());
+      std::for_each(counted.begin(),counted.end(),[&](const bill_ver_id_t& version) {
+         std::vector<unsigned int>& counts(result.stored[version]);
+         counts.assign(word_terms.Size(),0);
+         const auto found(stored.find(version));
+         if (found == stored.end()) return;
+         std::for_each(found->second.begin(),found->second.end(),[&](const TermCount& count) {
+            const auto term(current.find(TermId(count.polarity,count.term_key)));
+            if (term != current.end()) counts[term->second] = count.count;
+         });
       });
+      std::stringstream ss;
+      ss << result.changed.size() << " of " << word_terms.Size() << " ranking terms changed since the last run, "
+         << result.stored.size() << " bill versions have stored term counts";
+      LoggerNS::Logger::Log(ss.str());
+      return result;
+   }
+
+   // Map each bill version to the version before it.  Sorting groups the versions of a bill together, with the latest listed first.
+   std::map<bill_ver_id_t,bill_ver_id_t> PreviousVersions(CAPublic& db) {
+      std::map<bill_ver_id_t,bill_ver_id_t> result;
+      std::vector<BillRow> versions(db.ReadVersionTable());
+      std::sort(versions.begin(),versions.end());
+      for (size_t i = 0; i + 1 < versions.size(); ++i) {
+         if (versions[i].bill_id == versions[i+1].bill_id) result[versions[i].bill_version_id] = versions[i+1].bill_version_id;
+      }
+      return result;
+   }
+
+   // Whether ranking a bill needs its text.  Bills with stored counts are rescored without it while no term has changed.
+   bool NeedsText(const BillRow& entry) {
+      return !plan.changed.empty() || plan.stored.find(entry.bill_version_id) == plan.stored.end();
+   }
+
+   // Count an amended version from its amendments: the stored counts of the version it amends, plus the matches in the text
+   // the amendments insert, less those in the text they delete.  The unchanged body isn't counted.  Matches spanning the edge
+   // of an amendment are missed, and word terms are walked over the amendments' words rather than the whole text's, so the
+   // counts approximate those of the whole text.  They are never stored as the version's
+   // counts, so a run without --delta counts the whole text, and later amendments aren't counted from an approximation.
+   // Answers false if the version has no amendment markup, or the version it amends has no counts current with the terms.
+   bool RankAmendments(const BillRow& entry,boost::string_ref lob_contents,RankedCounts& ranked) {
+      if (!rank_from_amendments || !plan.changed.empty()) return false;
+      const auto previous(previous_versions.find(entry.bill_version_id));
+      if (previous == previous_versions.end()) return false;
+      const auto stored(plan.stored.find(previous->second));
+      if (stored == plan.stored.end()) return false;
+      std::string inserted,deleted;
+      if (!BillText::AmendmentText(lob_contents,inserted,deleted)) return false;
+
+      const TermSet& word_terms(ranker->Terms());
+      std::vector<unsigned int> inserted_counts,deleted_counts;
+      TokenVector words;
+      Tokenizer::Tokenize(inserted,words);
+      word_terms.CountText(inserted,words,inserted_counts);
+      Tokenizer::Tokenize(deleted,words);
+      word_terms.CountText(deleted,words,deleted_counts);
+      std::vector<unsigned int>& counts(ranked.breakdown.counts);
+      counts = stored->second;
+      for (unsigned int i = 0; i < counts.size(); ++i) {
+         counts[i] += inserted_counts[i];
+         counts[i] -= std::min(counts[i],deleted_counts[i]);
+      }
+      const TermSetScores before(word_terms.Tally(stored->second,false));
+      const TermSetScores after (word_terms.Tally(counts,false));
+      ranked.delta.previous_version_id = previous->second;
+      ranked.delta.neg_delta = static_cast<int>(after.neg_score) - static_cast<int>(before.neg_score);
+      ranked.delta.pos_delta = static_cast<int>(after.pos_score) - static_cast<int>(before.pos_score);
+      ranked.path = Amended;
+      return true;
+   }
+
+   // Score a single bill from the contents of its lob file, taking the cheapest path the stored counts allow.
+   // The contents are ignored when the bill doesn't need its text.  Text ranked before, perhaps as another version, isn't counted again.
+   // Safe to call concurrently, each thread with its own scratch -- the ranker and the plan are not modified once built.
+   bool RankBill(BillRow& entry,boost::string_ref lob_contents,RankedCounts& ranked,RankingScratch& scratch) {
+      const auto stored(plan.stored.find(entry.bill_version_id));
+      std::vector<unsigned int>& counts(ranked.breakdown.counts);
+      ranked.computed.clear();
+      if (!NeedsText(entry)) {
+         counts = stored->second;                                 // Only scores changed, no text processing
+         ranked.path = Rescored;
+      } else if (!RankAmendments(entry,lob_contents,ranked)) {
+         std::string& contents(scratch.text);
+         BillText::StripBillText(lob_contents,contents,scratch.tags);
+         ranked.text_hash = ContentHashText(ContentHash(contents));
+         const auto cached(cached_rankings.find(ranked.text_hash));
+         if (cached != cached_rankings.end() && cached->second.counts.size() == ranker->Terms().Size()) {
+            counts = cached->second.counts;                       // The same text was counted before, perhaps as another version
+            for (unsigned int i = 0; i < counts.size(); ++i) ranked.computed.push_back(i);
+            ranked.path = Cached;
+         } else if (stored != plan.stored.end()) {
+            // Count only the changed terms.  The words refer into contents; counting sorts them, after the phrases are counted.
+            Tokenizer::Tokenize(contents,scratch.words);
+            std::vector<unsigned int>& changed_counts(scratch.counts);
+            plan.changed_terms.CountText(contents,scratch.words,changed_counts,scratch.terms);
+            counts = stored->second;
+            for (unsigned int i = 0; i < plan.changed.size(); ++i) counts[plan.changed[i]] = changed_counts[i];
+            ranked.computed = plan.changed;
+            ranked.path = PartlyCounted;
+         } else {
+            ranker->RankText(contents,scratch,ranked.breakdown);
+            for (unsigned int i = 0; i < counts.size(); ++i) ranked.computed.push_back(i);
+            ranked.path = Counted;
+         }
+      }
+      // Generate every profile's positive and negative scores in a single pass over the counts
+      ranker->Tally(counts,ranked.breakdown);
+      entry.pos_score = ranked.breakdown.scores.pos_score;
+      entry.neg_score = ranked.breakdown.scores.neg_score;
+      if (entry.bill.length() == 0) entry.bill = entry.bill_version_id;
+      return true;
+   }
+
+   // Score a single bill, reading its lob file if need be.  Answers false if the bill has no lob file to rank.
+   bool RankBill(BillRow& entry,RankedCounts& ranked,RankingScratch& scratch) {
+      if (!NeedsText(entry)) return RankBill(entry,boost::string_ref(),ranked,scratch);
+      const std::string lob_path(BillText::LobPath(entry.lob));
+      if (lob_path.length() == 0) return false;
+      const MappedFile file(lob_path);
+      return RankBill(entry,file.Contents(),ranked,scratch);
+   }
+
+   // Write a ranked bill's scores under each configured profile.  Profile 0's scores are written with the bill's own.
+   void WriteProfileScores(const BillRow& entry,const ScoreBreakdown& breakdown,CAPublic& db) {
+      if (profile_names.size() <= 1) return;
+      std::vector<ProfileScore> profiles;
+      for (unsigned int p = 1; p < profile_names.size(); ++p) {
+         const TermSetScores scores(p < breakdown.profiles.size() ? breakdown.profiles[p] : TermSetScores());
+         profiles.push_back(ProfileScore(profile_names[p],scores.neg_score,scores.pos_score));
+      }
+      if (!db.WriteProfileScores(entry.bill_version_id,profiles)) LoggerNS::Logger::Log(std::string("Unable to write the profile scores of ") + entry.bill_version_id);
    }
 
-   // Fill a vector with the words in a string.
-   void TokenizeStringIntoVector(const std::string& source,WordVector& words) {
-      const std::regex splitOn("[^\\w]+");
-      std::sregex_token_iterator itr(source.begin(),source.end(),splitOn,-1);
-      const std::sregex_token_iterator endOfSequence;
-      words.clear();
-      words.reserve(250000);                             // TODO: Pass this value
-      while (itr != endOfSequence) {
-         const auto token((*itr++).str());               // Need string, not sub_match
-         if (token.length() > 0) words.push_back(token);
-      }
-   }
-
-   // Count words vector matches to a term in the ranking terms
-   // /arg r_start - looking for a match for this term
-   // /arg w_start - follows first match in the words vector
-   // /arg w_end   - stop  searching the words vector at this point
-   unsigned int CountMatches(
-      const std::regex& want_match,std::vector<std::string>::const_iterator w_start,std::vector<std::string>::const_iterator w_end) {
-      std::smatch m;
-      // Count matches, stopping on the first term that doesn't match.
-      const std::vector<std::string>::const_iterator w_first_match(w_start);
-      const std::vector<std::string>::const_iterator w_first_non_match(std::find_if(w_start,w_end,
-         [&](const std::string& item) { return !std::regex_search(item,m,want_match);
-      }));
-
-      // Return count of matches (one already found before entering this function)
-      return std::distance(w_first_match,w_first_non_match);
-   }
-
-   // Search through the words vector for the first instance of a term in the ranking terms
-   // /arg r_start - looking for a match for this term
-   // /arg w_start - start searching the words vector at this point
-   // /arg w_end   - stop  searching the words vector at this point
-   std::vector<std::string>::const_iterator FindFirstMatch(
-      const std::regex& want_match,std::vector<std::string>::const_iterator w_start,std::vector<std::string>::const_iterator w_end) {
-      std::smatch m;
-      return std::find_if(w_start,w_end,
-         [&](const std::string& item) { return std::regex_search(item,m,want_match);
+   // Write a ranked bill's scores to the database and report them to the log file.
+   // Scores are batched by the database's score writer; FlushBillScores commits the rest.
+   void WriteBillScores(const BillRow& entry,CAPublic& db) {
+      std::stringstream ss;
+      if (db.WriteBillScores(entry)) {
+         ss << entry.measure_type << " " << entry.measure_num << " Negative = " << entry.neg_score << ", Positive = " << entry.pos_score;
+      } else {
+         ss << "Unable to write the scores of " << entry.measure_type << " " << entry.measure_num;
+      }
+      LoggerNS::Logger::Log(ss.str());
+   }
+
+   // Writes ranked bills' scores and term counts to the database, and records how each bill was ranked
+   class RankingWriter {
+   public:
+      RankingWriter(CAPublic& database) : db(database) { paths.fill(0); }
+      void Write(const BillRow& entry,const RankedCounts& ranked);
+      void Finish();
+   private:
+      CAPublic&                     db;
+      std::array<size_t,RankPaths>  paths;
+      std::set<bill_ver_id_t>       current;                       // Versions whose stored counts match this run's terms
+   };
+
+   void RankingWriter::Write(const BillRow& entry,const RankedCounts& ranked) {
+      WriteBillScores(entry,db);
+      WriteProfileScores(entry,ranked.breakdown,db);
+      ++paths[ranked.path];
+      std::vector<TermCount> counts;
+      std::for_each(ranked.computed.begin(),ranked.computed.end(),[&](unsigned int term_index) {
+         counts.push_back(TermCount(ranker->Terms().Key(term_index),ranker->Terms().TermPolarity(term_index),ranked.breakdown.counts[term_index]));
       });
+      // An amended version's counts are approximate, so it is left uncounted, for the next full count
+      if (ranked.path != Amended) {
+         if (counts.empty() || db.WriteTermCounts(entry.bill_version_id,counts)) current.insert(entry.bill_version_id);
+         else LoggerNS::Logger::Log(std::string("Unable to store the term counts of ") + entry.bill_version_id);
+      }
+      if (ranked.path == Amended && !db.WriteAmendmentDelta(entry.bill_version_id,ranked.delta)) {
+         LoggerNS::Logger::Log(std::string("Unable to store the amendment score change of ") + entry.bill_version_id);
+      }
+      if ((ranked.path == Counted || ranked.path == PartlyCounted) && !ranked.text_hash.empty()) {
+         CachedRanking cached;
+         cached.neg_score = entry.neg_score;
+         cached.pos_score = entry.pos_score;
+         cached.counts = ranked.breakdown.counts;
+         if (!db.WriteCachedRanking(ranked.text_hash,term_set_hash,cached)) LoggerNS::Logger::Log(std::string("Unable to cache the ranking of ") + entry.lob);
+      }
+   }
+
+   // Record the terms the stored counts now reflect.
+   // Counted versions not ranked this run lack counts of the changed terms, so they are dropped from the counted set.
+   void RankingWriter::Finish() {
+      if (!plan.changed.empty()) {
+         std::vector<bill_ver_id_t> stale;
+         std::for_each(plan.stored.begin(),plan.stored.end(),[&](const std::pair<const bill_ver_id_t,std::vector<unsigned int>>& version) {
+            if (current.count(version.first) == 0) stale.push_back(version.first);
+         });
+         if (!stale.empty()) db.UncountBillVersions(stale);
+      }
+      const TermSet& word_terms(ranker->Terms());
+      std::vector<RankingTermRecord> terms;
+      for (unsigned int i = 0; i < word_terms.Size(); ++i) {
+         terms.push_back(RankingTermRecord(word_terms.Key(i),word_terms.TermPolarity(i),plan.hashes[i]));
+      }
+      if (!db.ReplaceStoredRankingTerms(terms)) LoggerNS::Logger::Log("Unable to store the ranking terms");
+      if (!db.RetainProfileScores(std::vector<std::string>(profile_names.begin()+1,profile_names.end()))) LoggerNS::Logger::Log("Unable to drop the scores of unconfigured profiles");
+      if (!db.PruneCachedRankings(term_set_hash)) LoggerNS::Logger::Log("Unable to prune the rankings cached under earlier ranking terms");
+      db.FlushBillScores();
+      std::stringstream ss;
+      ss << paths[Rescored] << " bills rescored from stored term counts, " << paths[PartlyCounted] << " counted for changed terms only, "
+         << paths[Cached] << " found in the ranking cache, " << paths[Amended] << " counted from their amendments, " << paths[Counted] << " counted for all terms";
+      LoggerNS::Logger::Log(ss.str());
    }
 
-   // Remove HTML from a string containing the text of a bill
-   void RemoveHTML(std::string& contents) {
-      // Remove standard bill prefix, including Legislative Counsel's digest
-      const std::string exp("The people of the State of California do enact as follows:");
-      const size_t splitHere(contents.find(exp));
-      if (splitHere != contents.npos) contents = std::string(contents.c_str()+splitHere+exp.length());
-
-      // Remove HTML
-      std::string s1(std::regex_replace(contents,std::regex("</?caml(.*?)>"),std::string()));
-      std::string s2(std::regex_replace(s1,std::regex("<em>(.*?)</em>"),std::string(" $1 ")));
-      std::string s3(std::regex_replace(s2,std::regex("<strike>(.*?)</strike>"),std::string()));
-      std::string s4(std::regex_replace(s3,std::regex("<p>(.*?)</p>"),std::string(" $1 ")));
-      std::string s5(std::regex_replace(s4,std::regex("<span class=.EnSpace./>"),std::string()));        // . instead of ""
-      contents = s5;
-
-      // Remove everything less than space.
-      std::for_each(contents.begin(),contents.end(),[](char& c) { if (c < ' ') c = ' '; });
-   }
-
-   // Rank a single bill by words.  The input word vector has been sorted.
-   unsigned int RankByWord(WordVector& words,const RankWordMap& wordRankingTerms,bool showDetails) {
-      unsigned int score(0);                          // Accumulate the bill's score
-      // Sort ranking terms in alphabetical order
-      WordVector rankingStrings;
-      AlphabetizedListOfRankingTerms(wordRankingTerms,rankingStrings);
-
-      // Search through the words vector for each instance of a term in the ranking terms
-      std::vector<std::string>::const_iterator current_words_starting_point(words.cbegin());
-      // rankingStrings and lower_case_rankingStrings differ only in case
-      std::for_each(rankingStrings.begin(),rankingStrings.end(),[&](const std::string& ranking_str) {
-         if (current_words_starting_point != words.cend()) {
-            const RankWordCItr looking_for(wordRankingTerms.find(ranking_str));
-            if (looking_for != wordRankingTerms.end()) {
-               const std::regex want_match(looking_for->second.first);
-               std::vector<std::string>::const_iterator w_itr = FindFirstMatch(want_match,current_words_starting_point,words.cend());
-               if (w_itr == words.cend()) {
-                  //std::cout << "   No match for " << ranking_str << std::endl; 
-               } else {
-                  // Increment score by number-of-matches time match-value
-                  unsigned int match_count(CountMatches(want_match,w_itr,words.cend()));
-                  const unsigned int worth(match_count * looking_for->second.second);
-                  score += worth;
-                  if (showDetails) {
-                     std::cout << "   " << match_count << " instances of " << ranking_str
-                        << " (" << looking_for->second.second << ")"
-                        << ", worth = " << worth
-                        << ", score = " << score
-                        << std::endl;
+   const size_t queue_capacity_per_ranker(4);                        // Bills queued ahead of each ranking thread
+
+   // Rank bills in a pipeline of stages joined by bounded lock-free queues, so reading lob files overlaps ranking them.
+   // A reader thread prefetches lob files, ranking threads score them, and the calling thread, the only database writer,
+   // writes their scores in the order of bills, so the database and the log match a serial run.
+   void RankBillsInPipeline(const std::vector<BillRow>& bills,RankingWriter& writer,unsigned int threads) {
+      enum { Pending, Ranked, Skipped, Failed };
+      struct PipelineBill {
+         BillRow      entry;                                          // Ranked copy, as in the serial loop
+         std::string  contents;                                       // Lob file, released once ranked
+         RankedCounts ranked;
+         int          state;
+         std::string  failure;
+         PipelineBill() : state(Pending) {}
+      };
+      std::vector<PipelineBill> pipeline(bills.size());
+      StageQueue read(threads * queue_capacity_per_ranker);
+      StageQueue ranked(threads * queue_capacity_per_ranker);
+
+      boost::thread reader([&]() {
+         for (size_t i = 0; i < pipeline.size(); ++i) {
+            PipelineBill& bill(pipeline[i]);
+            bill.entry = bills[i];
+            try {
+               if (NeedsText(bill.entry)) {
+                  const std::string lob_path(BillText::LobPath(bill.entry.lob));
+                  if (lob_path.length() == 0) bill.state = Skipped;
+                  else bill.contents = ReadFile(lob_path);
+               }
+            } catch (const std::exception& ex) {
+               bill.failure = ex.what();
+               bill.state = Failed;
+            }
+            if (!read.Push(i)) break;                                 // The writer stopped early
+         }
+         read.Close();
+      });
+
+      boost::atomic<unsigned int> ranking(threads);
+      boost::thread_group rankers;
+      for (unsigned int t = 0; t < threads; ++t) {
+         rankers.create_thread([&]() {
+            RankingScratch scratch;                                   // Reused for every bill this thread ranks
+            size_t i;
+            while (read.Pop(i)) {
+               PipelineBill& bill(pipeline[i]);
+               if (bill.state == Pending) {
+                  try {
+                     bill.state = RankBill(bill.entry,bill.contents,bill.ranked,scratch) ? Ranked : Skipped;
+                  } catch (const std::exception& ex) {
+                     bill.failure = ex.what();
+                     bill.state = Failed;
                   }
-                  current_words_starting_point = w_itr + match_count;
                }
+               std::string().swap(bill.contents);
+               if (!ranked.Push(i)) break;                            // The writer stopped early
+            }
+            if (--ranking == 0) ranked.Close();
+         });
+      }
+
+      // Bills ranked ahead of their turn wait until every bill before them is written
+      std::vector<bool> done(pipeline.size(),false);
+      size_t next(0),i;
+      try {
+         while (ranked.Pop(i)) {
+            done[i] = true;
+            for (; next < pipeline.size() && done[next]; ++next) {
+               PipelineBill& bill(pipeline[next]);
+               if (bill.state == Ranked) writer.Write(bill.entry,bill.ranked);
+               else if (bill.state == Failed) LoggerNS::Logger::Log(std::string("Unable to rank ") + bill.entry.lob + ": " + bill.failure);
+               bill.ranked = RankedCounts();
             }
          }
+      } catch (...) {
+         // Stop the reader and rankers, and wait for them, before the pipeline they share goes out of scope
+         read.Close();
+         ranked.Close();
+         reader.join();
+         rankers.join_all();
+         throw;
+      }
+      reader.join();
+      rankers.join_all();
+      LoggerNS::Logger::Log(read.Report("Read queue (reader to rankers)"));
+      LoggerNS::Logger::Log(ranked.Report("Ranked queue (rankers to writer)"));
+   }
+
+   // Count the word terms in the wanted bill versions from the word index, without reading lob files.
+   // Each version's words are read from the index and sorted, and the terms walked over them as over the words of its text.
+   std::map<bill_ver_id_t,std::vector<unsigned int>> CountTermsFromIndex(CAPublic& db,const std::set<bill_ver_id_t>& wanted) {
+      const TermSet& word_terms(ranker->Terms());
+      std::map<bill_ver_id_t,std::vector<unsigned int>> result;
+      TermScratch scratch;
+      TokenVector runs;
+      std::vector<unsigned int> run_lengths;
+      std::for_each(wanted.begin(),wanted.end(),[&](const bill_ver_id_t& version) {
+         std::vector<WordCount> words(db.IndexedWords(version));
+         std::sort(words.begin(),words.end(),[](const WordCount& a,const WordCount& b) { return Token(a.word) < Token(b.word); });
+         runs.clear();
+         run_lengths.clear();
+         std::for_each(words.begin(),words.end(),[&](const WordCount& word) {
+            runs.push_back(Token(word.word));
+            run_lengths.push_back(word.count);
+         });
+         std::vector<unsigned int>& counts(result[version]);
+         counts.assign(word_terms.Size(),0);
+         word_terms.CountWordRuns(runs,run_lengths,counts,scratch);
       });
-      return score;
+      return result;
    }
 }
 
 namespace BillRanker {
 
-   // Read positive and negative ranking terms from the configuration files
-   void ReadRankingTerms(const std::string& neg_fileName,const std::string& pos_fileName) {
-      const std::regex rx1("<Pair>.*?</Pair>");
-      const std::regex rx2("<Phrase>.*?</Phrase>");
-      const std::regex rx3("<Key>.*?</Key>|<Regex>.*?</Regex>|<Score>.*?</Score>");
-      const std::vector<std::string> neg_pairs1(ExtractRawTerms(neg_fileName,rx1));
-      const std::vector<std::string> neg_pairs2(ExtractRawTerms(neg_fileName,rx2));
-      const std::vector<std::string> pos_pairs1(ExtractRawTerms(pos_fileName,rx1));
-      const std::vector<std::string> pos_pairs2(ExtractRawTerms(pos_fileName,rx2));
-      neg_wordMap   = ExtractRankingTerms(neg_pairs1,rx3);
-      neg_phraseMap = ExtractRankingTerms(neg_pairs2,rx3);
-      pos_wordMap   = ExtractRankingTerms(pos_pairs1,rx3);
-      pos_phraseMap = ExtractRankingTerms(pos_pairs2,rx3);
+   // Read the positive and negative ranking terms of every profile from their configuration files, or from their caches.
+   // All profiles are compiled into one term set, so a bill's words are matched once however many profiles there are.
+   void ReadRankingTerms(const std::vector<RankingProfile>& profiles) {
+      boost::shared_ptr<TermSet> word_terms(new TermSet);
+      profile_names.clear();
+      for (unsigned int p = 0; p < profiles.size(); ++p) {
+         const RankingProfile& profile(profiles[p]);
+         std::stringstream name;
+         if (p > 0 && profile.name.empty()) name << "Profile " << p;
+         else                               name << profile.name;
+         profile_names.push_back(name.str());
+         const RankingTermFile negative(profile.negative.empty() ? RankingTermFile() : RankingTermFiles::Load(profile.negative));
+         const RankingTermFile positive(profile.positive.empty() ? RankingTermFile() : RankingTermFiles::Load(profile.positive));
+         word_terms->Add(InProfile(negative.pairs,p),TermSet::Negative,p);
+         word_terms->Add(InProfile(positive.pairs,p),TermSet::Positive,p);
+         word_terms->AddPhrases(InProfile(negative.phrases,p),TermSet::Negative,p);
+         word_terms->AddPhrases(InProfile(positive.phrases,p),TermSet::Positive,p);
+      }
+      word_terms->Compile();
+      ranker.reset(new TextRanker(word_terms));
+      std::stringstream ss;
+      ss << word_terms->Size() << " ranking terms in " << profile_names.size() << " ranking profiles";
+      LoggerNS::Logger::Log(ss.str());
    }
 
    // Generate bill rankings or read cached bill rankings
    // Report each bill's rankings to the log file.
-   std::vector<BillRanking> GenerateBillRankings(std::vector<BillRow>& bills,CAPublic& db,const std::string positive,const std::string negative) {
+   // Bills are read, ranked and written by a pipeline of threads.  Scores are still written by the calling thread,
+   // in the order of bills, so the database and the log match a serial run.
+   // With amendment_delta, amended versions whose previous version has stored counts are counted from their amendments alone.
+   std::vector<BillRanking> GenerateBillRankings(std::vector<BillRow>& bills,CAPublic& db,const std::vector<RankingProfile>& profiles,unsigned int threads,bool amendment_delta) {
       ScopedElapsedTime elapsed_time("Starting Rankings","Ranking Run Time: ");
-      BillRanker::ReadRankingTerms(negative,positive);
+      BillRanker::ReadRankingTerms(profiles);
       std::vector<BillRanker::BillRanking> rankings;
-      // Generate fresh ranking for each bill in bills
+      plan = PlanRescoring(db);
+      term_set_hash = TermSetHash();
+      cached_rankings = db.ReadCachedRankings(term_set_hash);
+      rank_from_amendments = amendment_delta;
+      previous_versions.clear();
+      if (amendment_delta) previous_versions = PreviousVersions(db);
+      {  std::stringstream ss;
+         ss << cached_rankings.size() << " bill texts have cached rankings under the current ranking terms";
+         LoggerNS::Logger::Log(ss.str());
+      }
+      RankingWriter writer(db);
+      const unsigned int rankers(std::max(1u,threads));
+      std::stringstream ss;
+      ss << "Ranking " << bills.size() << " bills with a reader, " << rankers << " ranking threads and a writer";
+      LoggerNS::Logger::Log(ss.str());
+      RankBillsInPipeline(bills,writer,rankers);
+      writer.Finish();
+      return rankings;
+   }
+
+   // Generate bill rankings from the word index built when leg site data was imported.
+   // Ranking terms are counted over each bill's words as indexed rather than its text, so changed terms
+   // are rescored without reading the lob files.  Bill versions missing from the index are ranked from their lob files.
+   // The index doesn't keep word order, so it can't count phrase terms.  With any, every bill is ranked from its lob file.
+   std::vector<BillRanking> GenerateBillRankingsFromIndex(std::vector<BillRow>& bills,CAPublic& db,const std::vector<RankingProfile>& profiles,unsigned int threads) {
+      BillRanker::ReadRankingTerms(profiles);
+      unsigned int phrases(0);
+      for (unsigned int i = 0; i < ranker->Terms().Size(); ++i) if (ranker->Terms().IsPhrase(i)) ++phrases;
+      if (phrases > 0) {
+         std::stringstream ss;
+         ss << "Not ranking from the word index: it doesn't keep word order, so it can't count the " << phrases
+            << " phrase terms.  Ranking every bill from its lob file instead.";
+         LoggerNS::Logger::Log(ss.str());
+         return GenerateBillRankings(bills,db,profiles,threads,false);
+      }
+      ScopedElapsedTime elapsed_time("Starting Rankings from word index","Ranking Run Time: ");
+      plan = RescorePlan();                                          // Stored term counts and cached rankings are neither used nor updated
+      cached_rankings.clear();
+      rank_from_amendments = false;
+      std::vector<BillRanker::BillRanking> rankings;
+      const std::vector<bill_ver_id_t> indexed_versions(db.IndexedBillVersions());
+      const std::set<bill_ver_id_t> indexed(indexed_versions.begin(),indexed_versions.end());
+      std::set<bill_ver_id_t> wanted;
+      std::for_each(bills.begin(),bills.end(),[&](const BillRow& entry) {
+         if (indexed.count(entry.bill_version_id) > 0) wanted.insert(entry.bill_version_id);
+      });
+      const std::map<bill_ver_id_t,std::vector<unsigned int>> counts(CountTermsFromIndex(db,wanted));
+
+      std::stringstream ss;
+      ss << "Ranking " << wanted.size() << " of " << bills.size() << " bills from the word index";
+      LoggerNS::Logger::Log(ss.str());
+      const std::vector<unsigned int> no_matches;
+      RankingScratch scratch;
       std::for_each(bills.begin(),bills.end(),[&](BillRow entry) {
-         const std::string raw_lob_files_folder("D:/CCHR/2017-2018/LatestDownload/Bills");
-         const std::string lob_path = (fs::path(raw_lob_files_folder) / entry.lob).string();
-         if (lob_path.length() > 0) {
-            std::string contents(ReadFile(lob_path));
-            RemoveHTML(contents);
-            // Collect all words into a vector, then sort them
-            WordVector words;
-            TokenizeStringIntoVector(contents,words);
-            std::sort(words.begin(),words.end());                    // Profiler shows the sort is not expensive -- less than 2%
-            // Generate positive and negative scores
-            entry.pos_score = RankByWord(words,pos_wordMap,false);
-            entry.neg_score = RankByWord(words,neg_wordMap,false);
+         if (wanted.count(entry.bill_version_id) > 0) {
+            const auto found(counts.find(entry.bill_version_id));
+            ScoreBreakdown breakdown;
+            ranker->Tally(found == counts.end() ? no_matches : found->second,breakdown);
+            entry.pos_score = breakdown.scores.pos_score;
+            entry.neg_score = breakdown.scores.neg_score;
             if (entry.bill.length() == 0) entry.bill = entry.bill_version_id;
-            std::stringstream ss1,ss2;
-            ss1 << "Update BillRows Set NegativeScore=" << entry.neg_score << ", PositiveScore=" << entry.pos_score << ", BillVersionId='" << entry.bill
-                << "' Where MeasureType='" << entry.measure_type << "' and MeasureNum='" << entry.measure_num << "';";
-            if (db.ExecuteSQL(ss1.str())) {
-               ss2 << entry.measure_type << " " << entry.measure_num << " Negative = " << entry.neg_score << ", Positive = " << entry.pos_score;
-               LoggerNS::Logger::Log(ss2.str());
-            } else {
-               ss2 << "Unable to execute SQL" << ss1.str();
-               LoggerNS::Logger::Log(ss2.str());
+            WriteBillScores(entry,db);
+            WriteProfileScores(entry,breakdown,db);
+         } else {
+            RankedCounts ranked;
+            if (RankBill(entry,ranked,scratch)) {
+               WriteBillScores(entry,db);
+               WriteProfileScores(entry,ranked.breakdown,db);
             }
          }
       });
+      db.FlushBillScores();
       return rankings;
    }
-}
\ No newline at end of file
+}
@@ -1,3 +1,4 @@
+#include <boost/thread/thread.hpp>                   // Ahead of CAPublic.h, whose Q and QC macros collide with boost::ratio
 #include <BillRanker.h>
 #include <CAPublic.h>
 #include <CommonTypes.h>
@@ -13,7 +14,9 @@
 #include "boost/program_options.hpp"
 #include <boost/scoped_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <utility>
 #include <vector>
@@ -25,11 +28,18 @@ namespace {
 	const std::string raw_lob_files_folder("D:/CCHR/2017-2018/LatestDownload/Bills");
 	const std::string cache_file_location("../Results/capublic.db");
 	bool import_leg_data(true);                  // If false, don't import leg site data into database
+   bool unjournaled_import(false);              // If true, import leg site data with the database journal off
+   bool incremental_import(false);              // If true, import only the leg site rows that changed, and rank only their bills
+   bool audit_query_plans(false);               // If true, report the queries that scan a whole table
 	int bill_processing_limit(0);
 	bool limit_bill_processing(false);
 	int bill_processing_counter(0);
 	bool process_all_bills(false);
    std::string process_single_bill;
+   unsigned int ranking_threads(1);             // Number of threads ranking bills.  0 means one per core.
+   bool rank_from_word_index(false);            // If true, score bills from the word index instead of their lob files
+   bool rank_amendment_deltas(false);           // If true, count amended versions from their amendments and the previous version's counts
+   unsigned int score_batch_size(1000);         // Bill scores written per database commit
 }
 
 #if RecordBillRowTablesForInspection 
@@ -71,7 +81,14 @@ namespace {
          ("all,a",po::value<bool>(&process_all_bills),"Process all bills")                               // "--all true"    causes all bills to be freshly evaluated
          ("bill,b",po::value<std::string>(&process_single_bill),"Process single bill")                   // "--bill AB123"  causes AB 123 (only) to be freshly evaluated
          ("import,i",po::value<bool>(&import_leg_data),"Whether to import leg data")                     // "--import true" causes data to be imported
-         ("limit,l",po::value<int>(&bill_processing_limit),"Limit bills processed");                     // "--limit 5"     limits to 5 bills processed
+         ("fresh,f",po::value<bool>(&unjournaled_import),"Import leg data without a journal")            // "--fresh true"  imports with journal_mode=OFF; a failed import must be rerun
+         ("update,u",po::value<bool>(&incremental_import),"Import only leg data that changed")           // "--update true" merges the leg data by trans_update, rather than reloading it
+         ("limit,l",po::value<int>(&bill_processing_limit),"Limit bills processed")                      // "--limit 5"     limits to 5 bills processed
+         ("threads,t",po::value<unsigned int>(&ranking_threads),"Threads ranking bills")                 // "--threads 8"   ranks 8 bills at a time, "--threads 0" one per core
+         ("postings,p",po::value<bool>(&rank_from_word_index),"Rank bills from the word index")          // "--postings true" scores bills from the word index built at import
+         ("delta,d",po::value<bool>(&rank_amendment_deltas),"Rank amended bills from their amendments")  // "--delta true"  counts only the text amendments insert and delete
+         ("commit,c",po::value<unsigned int>(&score_batch_size),"Bill scores per commit")                // "--commit 100"  commits bill scores 100 at a time
+         ("explain,e",po::value<bool>(&audit_query_plans),"Audit the plans of the queries run");         // "--explain true" logs the queries that scan a table, after ranking
       po::variables_map vm;
       try {
          po::store(po::parse_command_line(argc,argv,desc),vm);       // throws on error
@@ -95,6 +112,8 @@ namespace {
          process_all_bills = import_leg_data = limit_bill_processing = false;
       }
 
+      if (ranking_threads == 0) ranking_threads = std::max(1u,boost::thread::hardware_concurrency());
+
       return SUCCESS;
    }
 
@@ -137,13 +156,24 @@ std::vector<BillRow> SelectUnevaluatedBills(std::vector<BillRow>& completed_bill
    return result;
 }
 
+// Keep only the bills the incremental import changed.  changed_bills is sorted.
+std::vector<BillRow> SelectChangedBills(const std::vector<bill_id_t>& changed_bills, const std::vector<BillRow>& bills) {
+   std::vector<BillRow> result;
+   std::copy_if(bills.begin(),bills.end(),std::back_inserter(result),[&](const BillRow& bill) {
+      return std::binary_search(changed_bills.begin(),changed_bills.end(),bill.bill_id);
+   });
+   return result;
+}
+
 int main(int argc,char** argv) {
    ScopedElapsedTime elapsed_time("Starting Circus","Circus Run Time: ");
    ParseCommandLine(argc,argv);        // Extract command line arguments
 
    // Constructor handles importing leg site data files into database.
    // If 'import_leg_data' is false, then the current database contents are used.
-   CAPublic db(import_leg_data);
+   CAPublic db(import_leg_data,unjournaled_import,incremental_import);
+   db.BillScoreBatchSize(score_batch_size);
+   if (audit_query_plans) db.AuditQueryPlans();
 
    if (IsBillProcessingEnabled()) {
       std::vector<BillRow> bills_to_process,all_bill_versions,unevaluated_bill_versions,completed_bill_versions;
@@ -166,6 +196,7 @@ int main(int argc,char** argv) {
             all_bill_versions = SelectAllVersionsOfAllBills(db);
             unevaluated_bill_versions = SelectMostRecentVersionOfEachBill(all_bill_versions);
             bills_to_process = SelectUnevaluatedBills(completed_bill_versions,unevaluated_bill_versions);
+            if (import_leg_data && incremental_import) bills_to_process = SelectChangedBills(db.ChangedBills(),bills_to_process);
             ss << bills_to_process.size() << " bills have changed since the last run.";
             LoggerNS::Logger::Log(ss.str());
          }
@@ -177,8 +208,13 @@ int main(int argc,char** argv) {
       PrintBillRows("unevaluated_bills",unevaluated_bill_versions);
    #endif
 
-      // Rank those bills that have changed
-      BillRanker::GenerateBillRankings(bills_to_process,db,config->Password(), config->Negative());
+      // Rank those bills that have changed, under the configured keyword files and every listed profile
+      std::vector<RankingProfile> profiles(1,RankingProfile(std::string(),config->Negative(),config->Positive()));
+      const std::vector<RankingProfile> listed_profiles(config->Profiles());
+      profiles.insert(profiles.end(),listed_profiles.begin(),listed_profiles.end());
+      if (rank_from_word_index) BillRanker::GenerateBillRankingsFromIndex(bills_to_process,db,profiles,ranking_threads);
+      else                      BillRanker::GenerateBillRankings(bills_to_process,db,profiles,ranking_threads,rank_amendment_deltas);
       }
+   db.ReportQueryPlans();
    return 0;
    }